@@ -0,0 +1,272 @@
+#include "command_chunks.h"
+#include "dynamic_resolution.h"
+#include <chrono>
+
+namespace
+{
+    bool sameRecording(vector<draw_item> const& left, vector<draw_item> const& right)
+    {
+        return std::equal(begin(left), end(left), begin(right), end(right), [](draw_item const& leftDraw, draw_item const& rightDraw)
+        {
+            return leftDraw.command == rightDraw.command;
+        });
+    }
+
+    vector<VkCommandBuffer> allocateCommandBuffers(VkDevice const& logicalDevice, VkCommandPool const& commandPool, VkCommandBufferLevel const level, uint32_t const count)
+    {
+        vector<VkCommandBuffer> reply(count);
+
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = commandPool;
+        allocInfo.level = level;
+        allocInfo.commandBufferCount = count;
+        if(VK_FAILED(vkAllocateCommandBuffers(logicalDevice, &allocInfo, reply.data())))
+        {
+            throw std::runtime_error("Failed to allocate command buffers.");
+        }
+        return reply;
+    }
+}
+
+void command_chunks::create(VkDevice const& logicalDevice, VkCommandPool const& commandPool, chunked_frame_layout const& frameLayout)
+{
+    this->logicalDevice = logicalDevice;
+    this->commandPool = commandPool;
+    layout = frameLayout;
+    primaries = allocateCommandBuffers(logicalDevice, commandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, slotCount());
+    primaryStale.assign(slotCount(), 1);
+}
+
+void command_chunks::destroy()
+{
+    for(chunk_state const& chunk : chunks)
+    {
+        vkFreeCommandBuffers(logicalDevice, commandPool, static_cast<uint32_t>(chunk.secondaries.size()), chunk.secondaries.data());
+    }
+    if(!primaries.empty())
+    {
+        vkFreeCommandBuffers(logicalDevice, commandPool, static_cast<uint32_t>(primaries.size()), primaries.data());
+    }
+    chunks.clear();
+    primaries.clear();
+    primaryStale.clear();
+    executeScratch.clear();
+}
+
+uint32_t command_chunks::add(vector<draw_item> const& draws, bool const overlay)
+{
+    chunk_state state;
+    state.draws = draws;
+    state.overlay = overlay;
+    radixSortDrawItems(state.draws, sortScratch);
+    state.secondaries = allocateCommandBuffers(logicalDevice, commandPool, VK_COMMAND_BUFFER_LEVEL_SECONDARY, slotCount());
+    state.recordedVersions.assign(slotCount(), 0);
+    chunks.push_back(std::move(state));
+    executeScratch.reserve(chunks.size());
+    std::fill(begin(primaryStale), end(primaryStale), 1);
+    return static_cast<uint32_t>(chunks.size() - 1);
+}
+
+void command_chunks::update(uint32_t const index, vector<draw_item> const& draws)
+{
+    vector<draw_item> sorted = draws;
+    radixSortDrawItems(sorted, sortScratch);
+    chunk_state& state = chunks[index];
+    if(sameRecording(state.draws, sorted))
+    {
+        return;
+    }
+    state.draws.swap(sorted);
+    ++state.version;
+}
+
+void command_chunks::setVisible(uint32_t const index, bool const visible)
+{
+    chunk_state& state = chunks[index];
+    if(state.visible != visible)
+    {
+        state.visible = visible;
+        std::fill(begin(primaryStale), end(primaryStale), 1);
+    }
+}
+
+VkCommandBuffer command_chunks::prepare(uint32_t const imageIndex, uint32_t const level, frame_stats& stats)
+{
+    auto const start = std::chrono::steady_clock::now();
+    uint32_t const slot = level * static_cast<uint32_t>(layout.framebuffers.size()) + imageIndex;
+    uint32_t chunksRecorded = 0;
+    draw_bind_counters executed;
+    for(chunk_state& chunk : chunks)
+    {
+        if(!chunk.visible)
+        {
+            //hidden chunks catch up once they're shown again
+            continue;
+        }
+        if(chunk.recordedVersions[slot] != chunk.version)
+        {
+            recordSecondary(chunk, imageIndex, level);
+            chunk.recordedVersions[slot] = chunk.version;
+            ++chunksRecorded;
+        }
+        if(chunk.overlay)
+        {
+            continue;
+        }
+        executed.draws += chunk.counters.draws;
+        executed.pipelineBinds += chunk.counters.pipelineBinds;
+        executed.descriptorBinds += chunk.counters.descriptorBinds;
+        executed.vertexBinds += chunk.counters.vertexBinds;
+        executed.indexBinds += chunk.counters.indexBinds;
+        executed.bindsSaved += chunk.counters.bindsSaved;
+    }
+    //re-recording a secondary invalidates every primary that executes it
+    bool const primaryRecorded = primaryStale[slot] || chunksRecorded > 0;
+    if(primaryRecorded)
+    {
+        recordPrimary(imageIndex, level);
+        primaryStale[slot] = 0;
+    }
+
+    stats.recordingValid = true;
+    stats.chunkCount = chunkCount();
+    stats.chunksRecorded = chunksRecorded;
+    stats.primaryRecorded = primaryRecorded;
+    stats.recordMicroseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    stats.draws = executed.draws;
+    stats.pipelineBinds = executed.pipelineBinds;
+    stats.descriptorBinds = executed.descriptorBinds;
+    stats.vertexBinds = executed.vertexBinds;
+    stats.indexBinds = executed.indexBinds;
+    stats.bindsSaved = executed.bindsSaved;
+    return primaries[slot];
+}
+
+void command_chunks::recordSecondary(chunk_state& chunk, uint32_t const imageIndex, uint32_t const level)
+{
+    uint32_t const slot = level * static_cast<uint32_t>(layout.framebuffers.size()) + imageIndex;
+    VkCommandBuffer const& commandBuffer = chunk.secondaries[slot];
+
+    //the primary's queries are active while a scene chunk executes, so it has to say it can run under them
+    VkCommandBufferInheritanceInfo inheritanceInfo{};
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.subpass = 0;
+    if(chunk.overlay)
+    {
+        inheritanceInfo.renderPass = layout.overlayRenderPass;
+        inheritanceInfo.framebuffer = layout.overlayFramebuffers[imageIndex];
+    }
+    else
+    {
+        inheritanceInfo.renderPass = layout.renderPass;
+        inheritanceInfo.framebuffer = layout.framebuffers[imageIndex];
+        inheritanceInfo.occlusionQueryEnable = layout.statsPools.occlusion != VK_NULL_HANDLE;
+        inheritanceInfo.queryFlags = layout.statsPools.occlusionFlags;
+        inheritanceInfo.pipelineStatistics = layout.statsPools.pipelineStatistics != VK_NULL_HANDLE ? pipelineStatisticsFlags : 0;
+    }
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    beginInfo.pInheritanceInfo = &inheritanceInfo;
+    if(VK_FAILED(vkBeginCommandBuffer(commandBuffer, &beginInfo)))
+    {
+        throw std::runtime_error("Failed to begin recording a chunk.");
+    }
+
+    //dynamic state isn't inherited from the primary. overlays always cover the whole image.
+    if(layout.levelCount > 1 && !chunk.overlay)
+    {
+        VkExtent2D const renderExtent = resolutionExtent(layout.extent, level);
+        VkViewport const viewport = { 0.0f, 0.0f, static_cast<float>(renderExtent.width), static_cast<float>(renderExtent.height), 0.0f, 1.0f };
+        VkRect2D const scissor = { { 0, 0 }, renderExtent };
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+    }
+
+    chunk.counters = recordDrawList(commandBuffer, chunk.draws, imageIndex);
+
+    if(VK_FAILED(vkEndCommandBuffer(commandBuffer)))
+    {
+        throw std::runtime_error("Failed to record a chunk.");
+    }
+}
+
+void command_chunks::recordPrimary(uint32_t const imageIndex, uint32_t const level)
+{
+    uint32_t const slot = level * static_cast<uint32_t>(layout.framebuffers.size()) + imageIndex;
+    VkCommandBuffer const& commandBuffer = primaries[slot];
+    gpu_stats_pools const& statsPools = layout.statsPools;
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    if(VK_FAILED(vkBeginCommandBuffer(commandBuffer, &beginInfo)))
+    {
+        throw std::runtime_error("Failed to begin recording command buffer.");
+    }
+    resetStatsQueries(commandBuffer, statsPools, imageIndex);
+    writeFrameStartTimestamp(commandBuffer, statsPools, imageIndex);
+
+    //queries can't be begun inside a subpass whose contents are secondary command buffers, so they
+    //go around the whole pass
+    beginStatsQueries(commandBuffer, statsPools, imageIndex);
+    VkRenderPassBeginInfo renderPassInfo{};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassInfo.renderPass = layout.renderPass;
+    renderPassInfo.framebuffer = layout.framebuffers[imageIndex];
+    renderPassInfo.renderArea.offset = { 0,0 };
+    renderPassInfo.renderArea.extent = layout.levelCount > 1 ? resolutionExtent(layout.extent, level) : layout.extent;
+    VkClearValue clearColor = { 0.0f, 0.0f, 0.0f, 1.0f };
+    renderPassInfo.clearValueCount = 1;
+    renderPassInfo.pClearValues = &clearColor;
+
+    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+    executeChunks(commandBuffer, slot, false);
+    vkCmdEndRenderPass(commandBuffer);
+    endStatsQueries(commandBuffer, statsPools, imageIndex);
+
+    if(layout.levelCount > 1)
+    {
+        layout.upscale.renderExtent = renderPassInfo.renderArea.extent;
+        recordUpscaleBlit(commandBuffer, layout.upscale, imageIndex, layout.extent);
+    }
+    writeFrameEndTimestamp(commandBuffer, statsPools, imageIndex);
+
+    bool const overlayVisible = std::any_of(begin(chunks), end(chunks), [](chunk_state const& chunk)
+    {
+        return chunk.overlay && chunk.visible;
+    });
+    if(overlayVisible)
+    {
+        VkRenderPassBeginInfo overlayPassInfo{};
+        overlayPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        overlayPassInfo.renderPass = layout.overlayRenderPass;
+        overlayPassInfo.framebuffer = layout.overlayFramebuffers[imageIndex];
+        overlayPassInfo.renderArea.offset = { 0,0 };
+        overlayPassInfo.renderArea.extent = layout.extent;
+        vkCmdBeginRenderPass(commandBuffer, &overlayPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+        executeChunks(commandBuffer, slot, true);
+        vkCmdEndRenderPass(commandBuffer);
+    }
+    if(VK_FAILED(vkEndCommandBuffer(commandBuffer)))
+    {
+        throw std::runtime_error("Failed to record command buffer.");
+    }
+}
+
+void command_chunks::executeChunks(VkCommandBuffer const& commandBuffer, uint32_t const slot, bool const overlay)
+{
+    executeScratch.clear();
+    for(chunk_state const& chunk : chunks)
+    {
+        if(chunk.visible && chunk.overlay == overlay)
+        {
+            executeScratch.push_back(chunk.secondaries[slot]);
+        }
+    }
+    if(!executeScratch.empty())
+    {
+        vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(executeScratch.size()), executeScratch.data());
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "draw_list.h"
+
+//what the primaries record around the chunks
+struct chunked_frame_layout
+{
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    vector<VkFramebuffer> framebuffers;//one per swapchain image
+    VkExtent2D extent{};
+    //with more than one level each draws into the top left of the framebuffer at resolutionExtent
+    //and is blitted across with upscale, the pipelines then need a dynamic viewport
+    uint32_t levelCount = 1;
+    upscale_blit upscale;//renderExtent is filled in per level
+    gpu_stats_pools statsPools;
+
+    //overlay chunks draw over the finished frame at full size, only needed when there are any
+    VkRenderPass overlayRenderPass = VK_NULL_HANDLE;//loads the image, which stays in present layout
+    vector<VkFramebuffer> overlayFramebuffers;//over the swapchain images
+};
+
+//the scene split into chunks of draws, each recorded into a secondary command buffer per swapchain
+//image and resolution level the first time it's needed and again only after its draws change. the
+//primary around them is just the render passes, queries and blit, re-recorded when a chunk it
+//executes was or the visible set changed. nothing static is recorded twice.
+//
+//overlay chunks go in a pass of their own after the frame's queries, timestamps and blit, so
+//they never show up in the numbers gathered about the scene.
+class command_chunks
+{
+public:
+    //commandPool must allow resetting individual command buffers
+    void create(VkDevice const& logicalDevice, VkCommandPool const& commandPool, chunked_frame_layout const& frameLayout);
+    void destroy();
+
+    //draws are radix sorted on their keys, state shared between neighbours is only bound once
+    uint32_t add(vector<draw_item> const& draws, bool const overlay = false);
+
+    //a no-op when nothing recorded would differ
+    void update(uint32_t const index, vector<draw_item> const& draws);
+
+    //only the primaries are affected, a hidden chunk keeps its recordings
+    void setVisible(uint32_t const index, bool const visible);
+
+    vector<draw_item> const& draws(uint32_t const index) const { return chunks[index].draws; }
+    uint32_t chunkCount() const { return static_cast<uint32_t>(chunks.size()); }
+
+    //brings imageIndex's buffers at level up to date and returns the primary to submit. the image's
+    //previous submission must have retired. what was recorded is counted into stats, draws and
+    //binds only for the scene.
+    VkCommandBuffer prepare(uint32_t const imageIndex, uint32_t const level, frame_stats& stats);
+
+private:
+    struct chunk_state
+    {
+        vector<draw_item> draws;//sorted
+        draw_bind_counters counters;//from the latest recording, the same for every secondary
+        bool visible = true;
+        bool overlay = false;
+        uint64_t version = 1;
+        vector<VkCommandBuffer> secondaries;//level major, one per swapchain image
+        vector<uint64_t> recordedVersions;//per secondary, 0 until first recorded
+    };
+
+    uint32_t slotCount() const { return layout.levelCount * static_cast<uint32_t>(layout.framebuffers.size()); }
+    void recordSecondary(chunk_state& chunk, uint32_t const imageIndex, uint32_t const level);
+    void recordPrimary(uint32_t const imageIndex, uint32_t const level);
+    void executeChunks(VkCommandBuffer const& commandBuffer, uint32_t const slot, bool const overlay);
+
+    VkDevice logicalDevice = VK_NULL_HANDLE;
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    chunked_frame_layout layout;
+
+    vector<chunk_state> chunks;
+    vector<VkCommandBuffer> primaries;//level major, one per swapchain image
+    vector<uint8_t> primaryStale;
+    vector<VkCommandBuffer> executeScratch;//sized in add so recording never allocates
+    draw_sort_scratch sortScratch;
+};
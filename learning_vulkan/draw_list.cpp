@@ -0,0 +1,192 @@
+#include "draw_list.h"
+#include <array>
+
+bool operator==(draw_command const& left, draw_command const& right)
+{
+    return left.pipeline == right.pipeline
+        && left.pipelineLayout == right.pipelineLayout
+        && left.descriptorSet == right.descriptorSet
+        && left.vertexBuffer == right.vertexBuffer
+        && left.sliceBytes == right.sliceBytes
+        && left.instanceBuffer == right.instanceBuffer
+        && left.instanceSliceBytes == right.instanceSliceBytes
+        && left.instanceOffset == right.instanceOffset
+        && left.indexBuffer == right.indexBuffer
+        && left.indirectBuffer == right.indirectBuffer
+        && left.indirectOffset == right.indirectOffset
+        && left.vertexCount == right.vertexCount;
+}
+
+uint64_t makeDrawSortKey(draw_pass const pass, uint32_t const pipelineId, uint32_t const materialId, uint32_t const meshId, float const depth)
+{
+    //ids past what their field holds wrap, which only costs sort quality
+    uint64_t const stateMask = (1ull << drawKeyStateBits) - 1;
+    uint64_t const meshMask = (1ull << drawKeyMeshBits) - 1;
+    uint64_t const depthMask = (1ull << drawKeyDepthBits) - 1;
+    uint64_t const state = ((pipelineId & stateMask) << (drawKeyStateBits + drawKeyMeshBits))
+        | ((materialId & stateMask) << drawKeyMeshBits)
+        | (meshId & meshMask);
+    uint64_t const quantisedDepth = static_cast<uint64_t>(std::clamp(depth, 0.0f, 1.0f) * depthMask);
+
+    uint64_t const reply = static_cast<uint64_t>(pass) << (2 * drawKeyStateBits + drawKeyMeshBits + drawKeyDepthBits);
+    if(pass == draw_pass::transparent)
+    {
+        return reply | ((depthMask - quantisedDepth) << (2 * drawKeyStateBits + drawKeyMeshBits)) | state;
+    }
+    return reply | (state << drawKeyDepthBits) | quantisedDepth;
+}
+
+draw_item makeDrawItem(draw_command const& command, draw_pass const pass, float const depth, draw_state_ids& ids)
+{
+    draw_item reply;
+    reply.command = command;
+    reply.sortKey = makeDrawSortKey(pass, ids.pipelineId(command.pipeline), ids.materialId(command.descriptorSet), ids.meshId(command.vertexBuffer), depth);
+    return reply;
+}
+
+void radixSortDrawItems(vector<draw_item>& items, draw_sort_scratch& scratch)
+{
+    if(items.size() < 2)
+    {
+        return;
+    }
+    scratch.keys.resize(items.size());
+    scratch.swapKeys.resize(items.size());
+    for(uint32_t i = 0; i < items.size(); ++i)
+    {
+        scratch.keys[i] = { items[i].sortKey, i };
+    }
+
+    for(uint32_t shift = 0; shift < 64; shift += 8)
+    {
+        std::array<uint32_t, 256> offsets{};
+        for(auto const& key : scratch.keys)
+        {
+            ++offsets[(key.first >> shift) & 0xff];
+        }
+        //keys mostly differ in a few bytes, the rest would only shuffle everything into place again
+        if(offsets[(scratch.keys.front().first >> shift) & 0xff] == items.size())
+        {
+            continue;
+        }
+        uint32_t total = 0;
+        for(uint32_t& offset : offsets)
+        {
+            uint32_t const count = offset;
+            offset = total;
+            total += count;
+        }
+        for(auto const& key : scratch.keys)
+        {
+            scratch.swapKeys[offsets[(key.first >> shift) & 0xff]++] = key;
+        }
+        scratch.keys.swap(scratch.swapKeys);
+    }
+
+    scratch.items.resize(items.size());
+    for(uint32_t i = 0; i < items.size(); ++i)
+    {
+        scratch.items[i] = items[scratch.keys[i].second];
+    }
+    items.swap(scratch.items);
+}
+
+draw_bind_counters recordDrawList(VkCommandBuffer const& commandBuffer, vector<draw_item> const& items, uint32_t const imageIndex)
+{
+    draw_bind_counters reply;
+    VkPipeline boundPipeline = VK_NULL_HANDLE;
+    VkPipelineLayout boundLayout = VK_NULL_HANDLE;
+    VkDescriptorSet boundDescriptorSet = VK_NULL_HANDLE;
+    VkBuffer boundVertexBuffer = VK_NULL_HANDLE;
+    VkDeviceSize boundVertexOffset = 0;
+    VkBuffer boundInstanceBuffer = VK_NULL_HANDLE;
+    VkDeviceSize boundInstanceOffset = 0;
+    VkBuffer boundIndexBuffer = VK_NULL_HANDLE;
+    for(draw_item const& item : items)
+    {
+        draw_command const& draw = item.command;
+        if(draw.pipeline != boundPipeline)
+        {
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, draw.pipeline);
+            boundPipeline = draw.pipeline;
+            ++reply.pipelineBinds;
+        }
+        else
+        {
+            ++reply.bindsSaved;
+        }
+
+        if(draw.descriptorSet != VK_NULL_HANDLE)
+        {
+            //a set stays bound across pipelines only while their layouts agree
+            if(draw.descriptorSet != boundDescriptorSet || draw.pipelineLayout != boundLayout)
+            {
+                vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, draw.pipelineLayout, 0, 1, &draw.descriptorSet, 0, nullptr);
+                boundDescriptorSet = draw.descriptorSet;
+                boundLayout = draw.pipelineLayout;
+                ++reply.descriptorBinds;
+            }
+            else
+            {
+                ++reply.bindsSaved;
+            }
+        }
+
+        if(draw.vertexBuffer != VK_NULL_HANDLE)
+        {
+            VkDeviceSize const vertexOffset = imageIndex * draw.sliceBytes;
+            if(draw.vertexBuffer != boundVertexBuffer || vertexOffset != boundVertexOffset)
+            {
+                vkCmdBindVertexBuffers(commandBuffer, 0, 1, &draw.vertexBuffer, &vertexOffset);
+                boundVertexBuffer = draw.vertexBuffer;
+                boundVertexOffset = vertexOffset;
+                ++reply.vertexBinds;
+            }
+            else
+            {
+                ++reply.bindsSaved;
+            }
+        }
+
+        if(draw.instanceBuffer != VK_NULL_HANDLE)
+        {
+            VkDeviceSize const instanceOffset = imageIndex * draw.instanceSliceBytes + draw.instanceOffset;
+            if(draw.instanceBuffer != boundInstanceBuffer || instanceOffset != boundInstanceOffset)
+            {
+                vkCmdBindVertexBuffers(commandBuffer, 1, 1, &draw.instanceBuffer, &instanceOffset);
+                boundInstanceBuffer = draw.instanceBuffer;
+                boundInstanceOffset = instanceOffset;
+                ++reply.vertexBinds;
+            }
+            else
+            {
+                ++reply.bindsSaved;
+            }
+        }
+
+        if(draw.indexBuffer != VK_NULL_HANDLE)
+        {
+            if(draw.indexBuffer != boundIndexBuffer)
+            {
+                vkCmdBindIndexBuffer(commandBuffer, draw.indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+                boundIndexBuffer = draw.indexBuffer;
+                ++reply.indexBinds;
+            }
+            else
+            {
+                ++reply.bindsSaved;
+            }
+            vkCmdDrawIndexedIndirect(commandBuffer, draw.indirectBuffer, draw.indirectOffset + imageIndex * sizeof(VkDrawIndexedIndirectCommand), 1, sizeof(VkDrawIndexedIndirectCommand));
+        }
+        else if(draw.indirectBuffer != VK_NULL_HANDLE)
+        {
+            vkCmdDrawIndirect(commandBuffer, draw.indirectBuffer, draw.indirectOffset + imageIndex * sizeof(VkDrawIndirectCommand), 1, sizeof(VkDrawIndirectCommand));
+        }
+        else
+        {
+            vkCmdDraw(commandBuffer, draw.vertexCount, 1, 0, 0);
+        }
+        ++reply.draws;
+    }
+    return reply;
+}
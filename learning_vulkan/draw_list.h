@@ -0,0 +1,107 @@
+#pragma once
+
+#include "vulkan_init.h"
+
+//one draw. indexed when indexBuffer is set, counts are read from a command per swapchain image in
+//indirectBuffer, starting indirectOffset bytes in, when that is set, otherwise vertexCount vertices
+//are drawn directly. each image binds its own sliceBytes slice of vertexBuffer, a zero slice shares
+//it. instanceBuffer, when set, goes to binding 1 at instanceOffset into the image's
+//instanceSliceBytes slice. descriptorSet, when set, is bound at set 0 of pipelineLayout.
+struct draw_command
+{
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+    VkBuffer vertexBuffer = VK_NULL_HANDLE;
+    VkDeviceSize sliceBytes = 0;
+    VkBuffer instanceBuffer = VK_NULL_HANDLE;
+    VkDeviceSize instanceSliceBytes = 0;
+    VkDeviceSize instanceOffset = 0;
+    VkBuffer indexBuffer = VK_NULL_HANDLE;
+    VkBuffer indirectBuffer = VK_NULL_HANDLE;
+    VkDeviceSize indirectOffset = 0;
+    uint32_t vertexCount = 0;
+};
+
+bool operator==(draw_command const& left, draw_command const& right);
+
+enum class draw_pass : uint32_t
+{
+    opaque = 0,
+    transparent = 1,
+    overlay = 2,//after everything else, e.g. the hud
+};
+
+//opaque and overlay keys sort by state then front to back, so binds are shared and nearer draws go
+//first. transparent keys sort back to front ahead of state because the blend needs that order.
+//  opaque/overlay: pass 2 | pipeline 12 | material 12 | mesh 14 | depth 24
+//  transparent:    pass 2 | ~depth 24 | pipeline 12 | material 12 | mesh 14
+constexpr uint32_t drawKeyStateBits = 12;
+constexpr uint32_t drawKeyMeshBits = 14;
+constexpr uint32_t drawKeyDepthBits = 24;
+
+struct draw_item
+{
+    uint64_t sortKey = 0;
+    draw_command command;
+};
+
+//the small dense ids keys are built from, handed out in first seen order
+class draw_state_ids
+{
+public:
+    uint32_t pipelineId(VkPipeline const& pipeline) { return idOf(pipelines, pipeline); }
+    uint32_t materialId(VkDescriptorSet const& descriptorSet) { return idOf(materials, descriptorSet); }
+    uint32_t meshId(VkBuffer const& vertexBuffer) { return idOf(meshes, vertexBuffer); }
+
+private:
+    template<typename Handle>
+    static uint32_t idOf(vector<Handle>& handles, Handle const& handle)
+    {
+        auto const found = std::find(begin(handles), end(handles), handle);
+        if(found != end(handles))
+        {
+            return static_cast<uint32_t>(found - begin(handles));
+        }
+        handles.push_back(handle);
+        return static_cast<uint32_t>(handles.size() - 1);
+    }
+
+    vector<VkPipeline> pipelines;
+    vector<VkDescriptorSet> materials;
+    vector<VkBuffer> meshes;
+};
+
+//depth is the view distance over the far plane, clamped to [0, 1]
+uint64_t makeDrawSortKey(draw_pass const pass, uint32_t const pipelineId, uint32_t const materialId, uint32_t const meshId, float const depth);
+
+draw_item makeDrawItem(draw_command const& command, draw_pass const pass, float const depth, draw_state_ids& ids);
+
+//reused between sorts so they don't allocate once it has grown
+struct draw_sort_scratch
+{
+    vector<std::pair<uint64_t, uint32_t>> keys;//sort key and where the item came from
+    vector<std::pair<uint64_t, uint32_t>> swapKeys;
+    vector<draw_item> items;
+};
+
+//stable lsd radix sort on sortKey a byte at a time, skipping bytes every key shares. only the keys
+//move between passes, the items are gathered into place once at the end.
+void radixSortDrawItems(vector<draw_item>& items, draw_sort_scratch& scratch);
+
+//what recording a draw list bound, and what it didn't have to because the previous draw had it bound already
+struct draw_bind_counters
+{
+    uint32_t draws = 0;
+    uint32_t pipelineBinds = 0;
+    uint32_t descriptorBinds = 0;
+    uint32_t vertexBinds = 0;
+    uint32_t indexBinds = 0;
+    uint32_t bindsSaved = 0;
+
+    uint32_t binds() const { return pipelineBinds + descriptorBinds + vertexBinds + indexBinds; }
+};
+
+//records items in order, only binding what changed from the draw before. starts from nothing
+//bound, as a fresh secondary command buffer does.
+draw_bind_counters recordDrawList(VkCommandBuffer const& commandBuffer, vector<draw_item> const& items, uint32_t const imageIndex);
@@ -0,0 +1,71 @@
+#include "dynamic_resolution.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr double riseSmoothing = 0.3;//react quickly when frames get more expensive
+    constexpr double fallSmoothing = 0.05;
+    constexpr double raiseHeadroom = 0.8;//only climb when the next level is predicted well under budget
+}
+
+float resolutionScale(uint32_t const level)
+{
+    return resolutionMinimumScale + resolutionScaleStep * static_cast<float>(std::min(level, resolutionLevelCount - 1));
+}
+
+VkExtent2D resolutionExtent(VkExtent2D const& fullExtent, uint32_t const level)
+{
+    float const scale = resolutionScale(level);
+    return
+    {
+        std::max(1u, static_cast<uint32_t>(std::lround(fullExtent.width * scale))),
+        std::max(1u, static_cast<uint32_t>(std::lround(fullExtent.height * scale))),
+    };
+}
+
+resolution_controller::resolution_controller(double const targetMilliseconds)
+    : targetMilliseconds(targetMilliseconds)
+{
+}
+
+uint32_t resolution_controller::update(double const gpuMilliseconds, uint32_t const measuredLevel)
+{
+    float const scale = resolutionScale(measuredLevel);
+    double const fullResolution = gpuMilliseconds / (scale * scale);
+    if(fullResolutionMilliseconds == 0.0)
+    {
+        fullResolutionMilliseconds = fullResolution;
+    }
+    else
+    {
+        double const smoothing = fullResolution > fullResolutionMilliseconds ? riseSmoothing : fallSmoothing;
+        fullResolutionMilliseconds += (fullResolution - fullResolutionMilliseconds) * smoothing;
+    }
+
+    ++framesAtLevel;
+    uint32_t desiredLevel = currentLevel;
+    while(desiredLevel > 0 && predictedMilliseconds(desiredLevel) > targetMilliseconds)
+    {
+        --desiredLevel;
+    }
+    if(desiredLevel == currentLevel
+        && currentLevel + 1 < resolutionLevelCount
+        && framesAtLevel >= resolutionRaiseCooldownFrames
+        && predictedMilliseconds(currentLevel + 1) < targetMilliseconds * raiseHeadroom)
+    {
+        desiredLevel = currentLevel + 1;
+    }
+    if(desiredLevel != currentLevel)
+    {
+        currentLevel = desiredLevel;
+        framesAtLevel = 0;
+    }
+    return currentLevel;
+}
+
+double resolution_controller::predictedMilliseconds(uint32_t const level) const
+{
+    float const scale = resolutionScale(level);
+    return fullResolutionMilliseconds * scale * scale;
+}
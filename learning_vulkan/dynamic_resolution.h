@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+
+//render scales are quantised so every one can have its command buffers recorded up front:
+//50%, 60% ... 100% of the swapchain extent
+constexpr uint32_t resolutionLevelCount = 6;
+constexpr float resolutionMinimumScale = 0.5f;
+constexpr float resolutionScaleStep = 0.1f;
+constexpr uint32_t resolutionRaiseCooldownFrames = 30;//frames at a level before stepping back up
+
+float resolutionScale(uint32_t const level);
+
+//the top left part of a full size offscreen image a level renders into
+VkExtent2D resolutionExtent(VkExtent2D const& fullExtent, uint32_t const level);
+
+//picks a render scale from measured gpu time. the cost per full resolution frame is tracked by
+//dividing each measurement by the pixel fraction it was drawn at, so readings taken before a
+//change still count. drops as soon as the prediction is over budget, climbs only with headroom
+//to spare and after a cooldown so it doesn't bounce between two levels.
+class resolution_controller
+{
+public:
+    explicit resolution_controller(double const targetMilliseconds = 0.0);
+
+    //measuredLevel is the level the measured frame was drawn at, which lags behind level()
+    uint32_t update(double const gpuMilliseconds, uint32_t const measuredLevel);
+
+    uint32_t level() const { return currentLevel; }
+
+private:
+    double predictedMilliseconds(uint32_t const level) const;
+
+    double targetMilliseconds;
+    double fullResolutionMilliseconds = 0.0;//smoothed
+    uint32_t currentLevel = resolutionLevelCount - 1;
+    uint32_t framesAtLevel = 0;
+};
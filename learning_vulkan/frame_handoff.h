@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+constexpr double inputPollSeconds = 1.0 / 240.0;//longest the window thread sleeps between snapshots
+constexpr float cameraOrbitSpeed = 0.1f;//radians per second while no keys are held
+constexpr float cameraTurnSpeed = 1.5f;//radians per second with the arrow keys
+constexpr float cameraZoomSpeed = 40.0f;//units per second with w and s
+constexpr float cameraFieldOfView = 1.0f;//vertical, in radians
+constexpr float cameraNearPlane = 0.1f;
+constexpr float cameraFarPlane = 300.0f;
+constexpr uint32_t chunkToggleKeyCount = 9;//the number keys 1 to 9 show and hide the matching chunk
+
+//everything the render thread needs from the window thread for one frame. published whole and
+//never modified afterwards, so the renderer can read it without locks.
+struct frame_snapshot
+{
+    uint64_t sequence = 0;
+    double seconds = 0.0;//since the window thread started publishing
+    float cameraYaw = 0.0f;
+    float cameraPitch = 0.22f;
+    float cameraDistance = 92.0f;
+    uint32_t hiddenChunks = 0;//a bit per chunk, in the order each target adds them
+};
+
+//single producer, single consumer handoff of the newest value. the writer never waits for the
+//reader and the reader never sees a half written value. values the reader was too slow to pick
+//up are simply replaced.
+template<typename T>
+class triple_buffer
+{
+public:
+    //writer side: fill in the slot completely then publish it
+    T& writeSlot() { return slots[back]; }
+
+    void publish()
+    {
+        back = middle.exchange(static_cast<uint8_t>(back | freshBit), std::memory_order_acq_rel) & indexMask;
+    }
+
+    //reader side: true when something newer than readSlot() was published and has been swapped in
+    bool acquire()
+    {
+        if(!(middle.load(std::memory_order_relaxed) & freshBit))
+        {
+            return false;
+        }
+        front = middle.exchange(front, std::memory_order_acq_rel) & indexMask;
+        return true;
+    }
+
+    T const& readSlot() const { return slots[front]; }
+
+private:
+    static constexpr uint8_t freshBit = 4;
+    static constexpr uint8_t indexMask = 3;
+
+    std::array<T, 3> slots{};
+    alignas(64) uint8_t back = 0;//writer only
+    alignas(64) std::atomic<uint8_t> middle{ 1 };
+    alignas(64) uint8_t front = 2;//reader only
+};
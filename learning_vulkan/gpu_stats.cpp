@@ -0,0 +1,275 @@
+#include "vulkan_init.h"
+
+namespace
+{
+    gpu_stats_pools createTimestampPool(VkDevice const& logicalDevice, gpu_stats_pools reply, float const timestampPeriod, host_allocator& hostAllocator)
+    {
+        if(timestampPeriod > 0.0f)
+        {
+            reply.timestampPeriod = timestampPeriod;
+            VkQueryPoolCreateInfo timestampInfo{};
+            timestampInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+            timestampInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+            timestampInfo.queryCount = reply.slotCount * 2;
+            if(VK_FAILED(vkCreateQueryPool(logicalDevice, &timestampInfo, hostAllocator.callbacks(VK_OBJECT_TYPE_QUERY_POOL), &reply.timestamps)))
+            {
+                throw std::runtime_error("Failed to create the timestamp query pool.");
+            }
+        }
+        return reply;
+    }
+}
+
+gpu_stats_pools createStatsQueryPools(VkDevice const& logicalDevice, uint32_t const slotCount, VkPhysicalDeviceFeatures const& enabledFeatures, float const timestampPeriod, host_allocator& hostAllocator)
+{
+    gpu_stats_pools reply;
+    reply.slotCount = slotCount;
+    //the draws are executed from secondary command buffers, which can only run under an active
+    //query when the device lets them inherit it
+    if(!enabledFeatures.inheritedQueries)
+    {
+        return createTimestampPool(logicalDevice, reply, timestampPeriod, hostAllocator);
+    }
+    reply.occlusionFlags = enabledFeatures.occlusionQueryPrecise ? VK_QUERY_CONTROL_PRECISE_BIT : 0;
+
+    VkQueryPoolCreateInfo occlusionInfo{};
+    occlusionInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    occlusionInfo.queryType = VK_QUERY_TYPE_OCCLUSION;
+    occlusionInfo.queryCount = slotCount;
+    if(VK_FAILED(vkCreateQueryPool(logicalDevice, &occlusionInfo, hostAllocator.callbacks(VK_OBJECT_TYPE_QUERY_POOL), &reply.occlusion)))
+    {
+        throw std::runtime_error("Failed to create the occlusion query pool.");
+    }
+
+    if(enabledFeatures.pipelineStatisticsQuery)
+    {
+        VkQueryPoolCreateInfo statisticsInfo{};
+        statisticsInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        statisticsInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+        statisticsInfo.queryCount = slotCount;
+        statisticsInfo.pipelineStatistics = pipelineStatisticsFlags;
+        if(VK_FAILED(vkCreateQueryPool(logicalDevice, &statisticsInfo, hostAllocator.callbacks(VK_OBJECT_TYPE_QUERY_POOL), &reply.pipelineStatistics)))
+        {
+            throw std::runtime_error("Failed to create the pipeline statistics query pool.");
+        }
+    }
+    return createTimestampPool(logicalDevice, reply, timestampPeriod, hostAllocator);
+}
+
+void destroyStatsQueryPools(VkDevice const& logicalDevice, gpu_stats_pools const& pools, host_allocator& hostAllocator)
+{
+    if(pools.pipelineStatistics != VK_NULL_HANDLE)
+    {
+        vkDestroyQueryPool(logicalDevice, pools.pipelineStatistics, hostAllocator.callbacks(VK_OBJECT_TYPE_QUERY_POOL));
+    }
+    if(pools.timestamps != VK_NULL_HANDLE)
+    {
+        vkDestroyQueryPool(logicalDevice, pools.timestamps, hostAllocator.callbacks(VK_OBJECT_TYPE_QUERY_POOL));
+    }
+    if(pools.occlusion != VK_NULL_HANDLE)
+    {
+        vkDestroyQueryPool(logicalDevice, pools.occlusion, hostAllocator.callbacks(VK_OBJECT_TYPE_QUERY_POOL));
+    }
+}
+
+void resetStatsQueries(VkCommandBuffer const& commandBuffer, gpu_stats_pools const& pools, uint32_t const slot)
+{
+    if(pools.occlusion != VK_NULL_HANDLE)
+    {
+        vkCmdResetQueryPool(commandBuffer, pools.occlusion, slot, 1);
+    }
+    if(pools.pipelineStatistics != VK_NULL_HANDLE)
+    {
+        vkCmdResetQueryPool(commandBuffer, pools.pipelineStatistics, slot, 1);
+    }
+    if(pools.timestamps != VK_NULL_HANDLE)
+    {
+        vkCmdResetQueryPool(commandBuffer, pools.timestamps, slot * 2, 2);
+    }
+}
+
+void beginStatsQueries(VkCommandBuffer const& commandBuffer, gpu_stats_pools const& pools, uint32_t const slot)
+{
+    if(pools.occlusion != VK_NULL_HANDLE)
+    {
+        vkCmdBeginQuery(commandBuffer, pools.occlusion, slot, pools.occlusionFlags);
+    }
+    if(pools.pipelineStatistics != VK_NULL_HANDLE)
+    {
+        vkCmdBeginQuery(commandBuffer, pools.pipelineStatistics, slot, 0);
+    }
+}
+
+void endStatsQueries(VkCommandBuffer const& commandBuffer, gpu_stats_pools const& pools, uint32_t const slot)
+{
+    if(pools.pipelineStatistics != VK_NULL_HANDLE)
+    {
+        vkCmdEndQuery(commandBuffer, pools.pipelineStatistics, slot);
+    }
+    if(pools.occlusion != VK_NULL_HANDLE)
+    {
+        vkCmdEndQuery(commandBuffer, pools.occlusion, slot);
+    }
+}
+
+void writeFrameStartTimestamp(VkCommandBuffer const& commandBuffer, gpu_stats_pools const& pools, uint32_t const slot)
+{
+    if(pools.timestamps != VK_NULL_HANDLE)
+    {
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, pools.timestamps, slot * 2);
+    }
+}
+
+void writeFrameEndTimestamp(VkCommandBuffer const& commandBuffer, gpu_stats_pools const& pools, uint32_t const slot)
+{
+    if(pools.timestamps != VK_NULL_HANDLE)
+    {
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, pools.timestamps, slot * 2 + 1);
+    }
+}
+
+void readStatsQueries(VkDevice const& logicalDevice, gpu_stats_pools const& pools, uint32_t const slot, frame_stats& stats)
+{
+    stats.occlusionValid = false;
+    if(pools.occlusion != VK_NULL_HANDLE)
+    {
+        uint64_t samplesPassed = 0;
+        stats.occlusionValid = vkGetQueryPoolResults(logicalDevice, pools.occlusion, slot, 1,
+            sizeof(samplesPassed), &samplesPassed, sizeof(samplesPassed), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS;
+        if(stats.occlusionValid)
+        {
+            stats.samplesPassed = samplesPassed;
+        }
+    }
+
+    stats.pipelineStatisticsValid = false;
+    if(pools.pipelineStatistics != VK_NULL_HANDLE)
+    {
+        std::array<uint64_t, pipelineStatisticsCount> results{};
+        stats.pipelineStatisticsValid = vkGetQueryPoolResults(logicalDevice, pools.pipelineStatistics, slot, 1,
+            sizeof(results), results.data(), sizeof(results), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS;
+        if(stats.pipelineStatisticsValid)
+        {
+            stats.inputAssemblyVertices = results[0];
+            stats.inputAssemblyPrimitives = results[1];
+            stats.vertexShaderInvocations = results[2];
+            stats.clippingInvocations = results[3];
+            stats.clippingPrimitives = results[4];
+            stats.fragmentShaderInvocations = results[5];
+        }
+    }
+
+    stats.gpuTimeValid = false;
+    if(pools.timestamps != VK_NULL_HANDLE)
+    {
+        std::array<uint64_t, 2> ticks{};
+        stats.gpuTimeValid = vkGetQueryPoolResults(logicalDevice, pools.timestamps, slot * 2, 2,
+            sizeof(ticks), ticks.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS;
+        if(stats.gpuTimeValid)
+        {
+            stats.gpuMilliseconds = static_cast<double>(ticks[1] - ticks[0]) * pools.timestampPeriod / 1e6;
+        }
+    }
+}
+
+void queryMemoryBudget(VkPhysicalDevice const& physicalDevice, bool const budgetExtensionEnabled, frame_stats& stats)
+{
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+    budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+    VkPhysicalDeviceMemoryProperties2 memoryProperties{};
+    memoryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+    memoryProperties.pNext = budgetExtensionEnabled ? &budgetProperties : nullptr;
+    vkGetPhysicalDeviceMemoryProperties2(physicalDevice, &memoryProperties);
+
+    stats.memoryBudgetValid = budgetExtensionEnabled;
+    stats.heapCount = memoryProperties.memoryProperties.memoryHeapCount;
+    for(uint32_t i = 0; i < stats.heapCount; ++i)
+    {
+        VkMemoryHeap const& heap = memoryProperties.memoryProperties.memoryHeaps[i];
+        stats.heaps[i].size = heap.size;
+        stats.heaps[i].deviceLocal = (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+        //without the extension the whole heap is the best guess at a budget
+        stats.heaps[i].usage = budgetExtensionEnabled ? budgetProperties.heapUsage[i] : 0;
+        stats.heaps[i].budget = budgetExtensionEnabled ? budgetProperties.heapBudget[i] : heap.size;
+    }
+}
+
+void writeFrameStatsJson(std::ostream& out, frame_stats const& stats)
+{
+    out << "{\"frame\":" << stats.frameNumber
+        << ",\"target\":" << stats.targetIndex;
+    if(stats.pipelineStatisticsValid)
+    {
+        out << ",\"pipeline\":{"
+            << "\"inputAssemblyVertices\":" << stats.inputAssemblyVertices
+            << ",\"inputAssemblyPrimitives\":" << stats.inputAssemblyPrimitives
+            << ",\"vertexShaderInvocations\":" << stats.vertexShaderInvocations
+            << ",\"clippingInvocations\":" << stats.clippingInvocations
+            << ",\"clippingPrimitives\":" << stats.clippingPrimitives
+            << ",\"fragmentShaderInvocations\":" << stats.fragmentShaderInvocations
+            << '}';
+    }
+    if(stats.occlusionValid)
+    {
+        out << ",\"samplesPassed\":" << stats.samplesPassed;
+    }
+    if(stats.gpuTimeValid)
+    {
+        out << ",\"gpuMs\":" << stats.gpuMilliseconds;
+    }
+    out << ",\"resolutionScale\":" << stats.resolutionScale;
+    if(stats.cullingValid)
+    {
+        out << ",\"culling\":{"
+            << "\"kernel\":\"" << stats.cullKernel << '"'
+            << ",\"total\":" << stats.instancesTotal
+            << ",\"visible\":" << stats.instancesVisible
+            << ",\"microseconds\":" << stats.cullMicroseconds
+            << '}';
+    }
+    if(stats.meshLodValid)
+    {
+        out << ",\"meshLod\":{"
+            << "\"copies\":" << stats.meshCopiesTotal
+            << ",\"visible\":" << stats.meshCopiesVisible
+            << ",\"triangles\":" << stats.meshTriangles
+            << ",\"fullDetailTriangles\":" << stats.meshFullDetailTriangles
+            << ",\"microseconds\":" << stats.meshLodMicroseconds
+            << '}';
+    }
+    if(stats.recordingValid)
+    {
+        out << ",\"recording\":{"
+            << "\"chunks\":" << stats.chunkCount
+            << ",\"chunksRecorded\":" << stats.chunksRecorded
+            << ",\"primaryRecorded\":" << (stats.primaryRecorded ? "true" : "false")
+            << ",\"microseconds\":" << stats.recordMicroseconds
+            << ",\"draws\":" << stats.draws
+            << ",\"pipelineBinds\":" << stats.pipelineBinds
+            << ",\"descriptorBinds\":" << stats.descriptorBinds
+            << ",\"vertexBinds\":" << stats.vertexBinds
+            << ",\"indexBinds\":" << stats.indexBinds
+            << ",\"bindsSaved\":" << stats.bindsSaved
+            << '}';
+    }
+    out << ",\"hostAllocations\":{"
+        << "\"total\":" << stats.hostAllocations
+        << ",\"liveBytes\":" << stats.hostLiveBytes
+        << ",\"steadyState\":" << stats.steadyStateHostAllocations
+        << '}';
+    out << ",\"memoryBudgetValid\":" << (stats.memoryBudgetValid ? "true" : "false")
+        << ",\"heaps\":[";
+    for(uint32_t i = 0; i < stats.heapCount; ++i)
+    {
+        heap_budget const& heap = stats.heaps[i];
+        out << (i ? "," : "")
+            << "{\"index\":" << i
+            << ",\"deviceLocal\":" << (heap.deviceLocal ? "true" : "false")
+            << ",\"size\":" << heap.size
+            << ",\"usage\":" << heap.usage
+            << ",\"budget\":" << heap.budget
+            << '}';
+    }
+    out << "]}\n";
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include "host_allocator.h"
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+
+//the statistics captured per draw, results come back from the driver in this bit order
+constexpr VkQueryPipelineStatisticFlags pipelineStatisticsFlags = VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT
+    | VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT
+    | VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT
+    | VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT
+    | VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT
+    | VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+constexpr uint32_t pipelineStatisticsCount = 6;
+constexpr uint32_t statsLogInterval = 600;//frames between json dumps to stdout
+constexpr uint32_t memoryBudgetInterval = 30;//frames between heap budget queries, hud or not
+constexpr uint64_t hostAllocationWarmupFrames = 120;
+
+struct gpu_stats_pools
+{
+    VkQueryPool pipelineStatistics = VK_NULL_HANDLE;//null when the device lacks pipelineStatisticsQuery or inheritedQueries
+    VkQueryPool occlusion = VK_NULL_HANDLE;//null when the device lacks inheritedQueries
+    VkQueryControlFlags occlusionFlags = 0;
+    VkQueryPool timestamps = VK_NULL_HANDLE;//two per slot, null when the graphics queue can't write them
+    float timestampPeriod = 0.0f;//nanoseconds per tick
+    uint32_t slotCount = 0;
+};
+
+struct heap_budget
+{
+    VkDeviceSize size;
+    VkDeviceSize usage;//only meaningful when VK_EXT_memory_budget is enabled
+    VkDeviceSize budget;
+    bool deviceLocal;
+};
+
+//fixed size so that filling one in per frame never touches the heap
+struct frame_stats
+{
+    uint64_t frameNumber = 0;
+    uint32_t targetIndex = 0;//which presentation target the numbers belong to
+
+    bool pipelineStatisticsValid = false;
+    uint64_t inputAssemblyVertices = 0;
+    uint64_t inputAssemblyPrimitives = 0;
+    uint64_t vertexShaderInvocations = 0;
+    uint64_t clippingInvocations = 0;
+    uint64_t clippingPrimitives = 0;
+    uint64_t fragmentShaderInvocations = 0;
+
+    bool occlusionValid = false;
+    uint64_t samplesPassed = 0;
+
+    //from the top to the bottom of the target's command buffer, and the render scale it was drawn at
+    bool gpuTimeValid = false;
+    double gpuMilliseconds = 0.0;
+    float resolutionScale = 1.0f;
+
+    //heap figures are refreshed every memoryBudgetInterval frames rather than every frame
+    bool memoryBudgetValid = false;
+    uint32_t heapCount = 0;
+    std::array<heap_budget, VK_MAX_MEMORY_HEAPS> heaps{};
+
+    //driver host allocations through host_allocator, as of the frame these stats are for
+    uint64_t hostAllocations = 0;
+    uint64_t hostLiveBytes = 0;
+    uint64_t steadyStateHostAllocations = 0;//since hostAllocationWarmupFrames, should stay zero
+
+    //cpu frustum culling, for the frame most recently culled into this target
+    bool cullingValid = false;
+    char const* cullKernel = "";
+    uint32_t instancesTotal = 0;
+    uint32_t instancesVisible = 0;
+    double cullMicroseconds = 0.0;
+
+    //mesh copies after culling and the triangles their levels of detail came to, against drawing
+    //every one of them at full detail
+    bool meshLodValid = false;
+    uint32_t meshCopiesTotal = 0;
+    uint32_t meshCopiesVisible = 0;
+    uint64_t meshTriangles = 0;
+    uint64_t meshFullDetailTriangles = 0;
+    double meshLodMicroseconds = 0.0;
+
+    //secondary command buffer chunks re-recorded for the frame most recently prepared in this target,
+    //zero and no primary once nothing is changing
+    bool recordingValid = false;
+    uint32_t chunkCount = 0;
+    uint32_t chunksRecorded = 0;
+    bool primaryRecorded = false;
+    double recordMicroseconds = 0.0;
+
+    //what the frame's scene chunks execute, with the binds sorting let them skip. overlays aren't counted.
+    uint32_t draws = 0;
+    uint32_t pipelineBinds = 0;
+    uint32_t descriptorBinds = 0;
+    uint32_t vertexBinds = 0;
+    uint32_t indexBinds = 0;
+    uint32_t bindsSaved = 0;
+};
+
+//timestampPeriod comes from the device limits, 0 when timestampComputeAndGraphics is not supported
+gpu_stats_pools createStatsQueryPools(VkDevice const& logicalDevice, uint32_t const slotCount, VkPhysicalDeviceFeatures const& enabledFeatures, float const timestampPeriod, host_allocator& hostAllocator);
+
+void destroyStatsQueryPools(VkDevice const& logicalDevice, gpu_stats_pools const& pools, host_allocator& hostAllocator);
+
+//must be recorded outside of a render pass
+void resetStatsQueries(VkCommandBuffer const& commandBuffer, gpu_stats_pools const& pools, uint32_t const slot);
+
+//around the scene's render pass, a subpass made of secondary command buffers can't begin queries itself
+void beginStatsQueries(VkCommandBuffer const& commandBuffer, gpu_stats_pools const& pools, uint32_t const slot);
+
+void endStatsQueries(VkCommandBuffer const& commandBuffer, gpu_stats_pools const& pools, uint32_t const slot);
+
+//bracket the scene and its upscale in the slot's command buffer, outside of any render pass
+void writeFrameStartTimestamp(VkCommandBuffer const& commandBuffer, gpu_stats_pools const& pools, uint32_t const slot);
+
+void writeFrameEndTimestamp(VkCommandBuffer const& commandBuffer, gpu_stats_pools const& pools, uint32_t const slot);
+
+//non blocking, call once the fence guarding the slot's last submission has signalled
+void readStatsQueries(VkDevice const& logicalDevice, gpu_stats_pools const& pools, uint32_t const slot, frame_stats& stats);
+
+void queryMemoryBudget(VkPhysicalDevice const& physicalDevice, bool const budgetExtensionEnabled, frame_stats& stats);
+
+void writeFrameStatsJson(std::ostream& out, frame_stats const& stats);
@@ -0,0 +1,365 @@
+#include "host_allocator.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+    constexpr size_t minimumBlockSize = 16;
+    constexpr uint16_t largeSizeClass = UINT16_MAX;
+
+    //sits directly in front of every pointer handed to the driver
+    struct block_header
+    {
+        uint64_t size;
+        uint32_t offset;//from the start of the block to the payload
+        uint16_t sizeClass;
+        uint8_t scope;
+        uint8_t typeIndex;
+    };
+    static_assert(sizeof(block_header) == minimumBlockSize, "block header must keep payloads 16 byte aligned");
+
+    constexpr size_t sizeClassBytes(uint32_t const sizeClass)
+    {
+        return minimumBlockSize << sizeClass;
+    }
+
+    uint16_t sizeClassFor(size_t const blockSize)
+    {
+        for(uint32_t sizeClass = 0; sizeClass < hostAllocatorSizeClassCount; ++sizeClass)
+        {
+            if(sizeClassBytes(sizeClass) >= blockSize)
+            {
+                return static_cast<uint16_t>(sizeClass);
+            }
+        }
+        return largeSizeClass;
+    }
+
+    size_t blockSizeFor(size_t const size, size_t const alignment)
+    {
+        //blocks start 16 byte aligned so only stricter alignments need padding
+        return size + sizeof(block_header) + (alignment > minimumBlockSize ? alignment - minimumBlockSize : 0);
+    }
+
+    char* alignUp(char* pointer, size_t const alignment)
+    {
+        uintptr_t const address = reinterpret_cast<uintptr_t>(pointer);
+        return reinterpret_cast<char*>((address + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1));
+    }
+
+    block_header* headerOf(void* payload)
+    {
+        return reinterpret_cast<block_header*>(static_cast<char*>(payload) - sizeof(block_header));
+    }
+
+    uint8_t trackedObjectTypeIndex(VkObjectType const objectType)
+    {
+        if(objectType <= VK_OBJECT_TYPE_COMMAND_POOL)
+        {
+            return static_cast<uint8_t>(objectType);
+        }
+        if(objectType == VK_OBJECT_TYPE_SURFACE_KHR)
+        {
+            return 26;
+        }
+        if(objectType == VK_OBJECT_TYPE_SWAPCHAIN_KHR)
+        {
+            return 27;
+        }
+        return VK_OBJECT_TYPE_UNKNOWN;
+    }
+
+    char const* const trackedObjectTypeNames[trackedObjectTypeCount] =
+    {
+        "unknown", "instance", "physicalDevice", "device", "queue", "semaphore", "commandBuffer",
+        "fence", "deviceMemory", "buffer", "image", "event", "queryPool", "bufferView", "imageView",
+        "shaderModule", "pipelineCache", "pipelineLayout", "renderPass", "pipeline", "descriptorSetLayout",
+        "sampler", "descriptorPool", "descriptorSet", "framebuffer", "commandPool", "surface", "swapchain",
+    };
+
+    char const* const scopeNames[systemAllocationScopeCount] =
+    {
+        "command", "object", "cache", "device", "instance",
+    };
+
+    void addLiveBytes(host_allocation_counters& counters, uint64_t const size)
+    {
+        uint64_t const live = counters.liveBytes.fetch_add(size) + size;
+        uint64_t peak = counters.peakBytes.load();
+        while(live > peak && !counters.peakBytes.compare_exchange_weak(peak, live))
+        {
+        }
+    }
+
+    void writeCountersJson(std::ostream& out, host_allocation_counters const& counters)
+    {
+        out << "{\"allocations\":" << counters.allocations.load()
+            << ",\"reallocations\":" << counters.reallocations.load()
+            << ",\"frees\":" << counters.frees.load()
+            << ",\"liveBytes\":" << counters.liveBytes.load()
+            << ",\"peakBytes\":" << counters.peakBytes.load()
+            << '}';
+    }
+}
+
+host_allocator::host_allocator(bool const enabled) : enabled(enabled)
+{
+    for(object_type_binding& binding : bindings)
+    {
+        binding.owner = this;
+        binding.typeIndex = static_cast<uint8_t>(&binding - &bindings[0]);
+        binding.callbacks.pUserData = &binding;
+        binding.callbacks.pfnAllocation = allocationFunction;
+        binding.callbacks.pfnReallocation = reallocationFunction;
+        binding.callbacks.pfnFree = freeFunction;
+        binding.callbacks.pfnInternalAllocation = internalAllocationNotification;
+        binding.callbacks.pfnInternalFree = internalFreeNotification;
+    }
+}
+
+host_allocator::~host_allocator()
+{
+    for(void* block : arenaBlocks)
+    {
+        std::free(block);
+    }
+}
+
+VkAllocationCallbacks const* host_allocator::callbacks(VkObjectType const objectType) const
+{
+    return enabled ? &bindings[trackedObjectTypeIndex(objectType)].callbacks : nullptr;
+}
+
+uint64_t host_allocator::allocationCount() const
+{
+    uint64_t reply = 0;
+    for(host_allocation_counters const& counters : scopeCounters)
+    {
+        reply += counters.allocations.load() + counters.reallocations.load();
+    }
+    return reply;
+}
+
+uint64_t host_allocator::liveBytes() const
+{
+    uint64_t reply = 0;
+    for(host_allocation_counters const& counters : scopeCounters)
+    {
+        reply += counters.liveBytes.load();
+    }
+    return reply;
+}
+
+void host_allocator::writeReportJson(std::ostream& out) const
+{
+    size_t arenaBlockCount;
+    {
+        std::lock_guard<std::mutex> guard(arenaLock);
+        arenaBlockCount = arenaBlocks.size();
+    }
+    out << "{\"hostAllocator\":{\"enabled\":" << (enabled ? "true" : "false")
+        << ",\"arenaBlocks\":" << arenaBlockCount
+        << ",\"scopes\":{";
+    for(uint32_t scope = 0; scope < systemAllocationScopeCount; ++scope)
+    {
+        out << (scope ? "," : "") << '"' << scopeNames[scope] << "\":";
+        writeCountersJson(out, scopeCounters[scope]);
+    }
+    out << "},\"objectTypes\":{";
+    bool first = true;
+    for(uint32_t typeIndex = 0; typeIndex < trackedObjectTypeCount; ++typeIndex)
+    {
+        if(typeCounters[typeIndex].allocations.load() == 0)
+        {
+            continue;
+        }
+        out << (first ? "" : ",") << '"' << trackedObjectTypeNames[typeIndex] << "\":";
+        writeCountersJson(out, typeCounters[typeIndex]);
+        first = false;
+    }
+    out << "},\"internal\":";
+    writeCountersJson(out, internalCounters);
+    out << "}}\n";
+}
+
+void* host_allocator::allocate(size_t const size, size_t const alignment, VkSystemAllocationScope const scope, uint8_t const typeIndex)
+{
+    if(size == 0)
+    {
+        return nullptr;
+    }
+    size_t const blockSize = blockSizeFor(size, alignment);
+    uint16_t const sizeClass = sizeClassFor(blockSize);
+
+    char* block;
+    if(sizeClass == largeSizeClass)
+    {
+        //malloc only promises 8 bytes on 32 bit targets, leave room to reach 16
+        block = static_cast<char*>(std::malloc(blockSize + minimumBlockSize));
+    }
+    else
+    {
+        block = static_cast<char*>(takeBlock(sizeClass));
+    }
+    if(!block)
+    {
+        return nullptr;
+    }
+
+    char* payload = alignUp(block + sizeof(block_header), std::max(alignment, minimumBlockSize));
+    block_header* header = headerOf(payload);
+    header->size = size;
+    header->offset = static_cast<uint32_t>(payload - block);
+    header->sizeClass = sizeClass;
+    header->scope = static_cast<uint8_t>(scope);
+    header->typeIndex = typeIndex;
+
+    recordAllocation(scope, typeIndex, size);
+    return payload;
+}
+
+void* host_allocator::reallocate(void* original, size_t const size, size_t const alignment, VkSystemAllocationScope const scope, uint8_t const typeIndex)
+{
+    if(!original)
+    {
+        return allocate(size, alignment, scope, typeIndex);
+    }
+    if(size == 0)
+    {
+        release(original);
+        return nullptr;
+    }
+
+    block_header* header = headerOf(original);
+    if(header->sizeClass != largeSizeClass && header->offset + size <= sizeClassBytes(header->sizeClass))
+    {
+        //still fits in the block it already has
+        VkSystemAllocationScope const originalScope = static_cast<VkSystemAllocationScope>(header->scope);
+        recordResize(originalScope, header->typeIndex, header->size, size);
+        header->size = size;
+        return original;
+    }
+
+    void* reply = allocate(size, alignment, scope, typeIndex);
+    if(reply)
+    {
+        std::memcpy(reply, original, std::min<uint64_t>(size, header->size));
+        release(original);
+    }
+    return reply;
+}
+
+void host_allocator::release(void* memory)
+{
+    if(!memory)
+    {
+        return;
+    }
+    block_header* header = headerOf(memory);
+    recordFree(static_cast<VkSystemAllocationScope>(header->scope), header->typeIndex, header->size);
+
+    char* block = static_cast<char*>(memory) - header->offset;
+    if(header->sizeClass == largeSizeClass)
+    {
+        std::free(block);
+        return;
+    }
+    size_class_pool& pool = pools[header->sizeClass];
+    std::lock_guard<std::mutex> guard(pool.lock);
+    *reinterpret_cast<void**>(block) = pool.freeList;
+    pool.freeList = block;
+}
+
+void* host_allocator::takeBlock(uint32_t const sizeClass)
+{
+    {
+        size_class_pool& pool = pools[sizeClass];
+        std::lock_guard<std::mutex> guard(pool.lock);
+        if(pool.freeList)
+        {
+            void* reply = pool.freeList;
+            pool.freeList = *static_cast<void**>(reply);
+            return reply;
+        }
+    }
+    return carveFromArena(sizeClassBytes(sizeClass));
+}
+
+void* host_allocator::carveFromArena(size_t const blockSize)
+{
+    std::lock_guard<std::mutex> guard(arenaLock);
+    if(arenaRemaining < blockSize)
+    {
+        //the tail of the old arena block is abandoned, it is at most one 4KiB block's worth
+        char* arenaBlock = static_cast<char*>(std::malloc(hostAllocatorArenaBlockSize));
+        if(!arenaBlock)
+        {
+            return nullptr;
+        }
+        arenaBlocks.push_back(arenaBlock);
+        arenaCursor = alignUp(arenaBlock, minimumBlockSize);
+        arenaRemaining = hostAllocatorArenaBlockSize - (arenaCursor - arenaBlock);
+    }
+    void* reply = arenaCursor;
+    arenaCursor += blockSize;
+    arenaRemaining -= blockSize;
+    return reply;
+}
+
+void host_allocator::recordAllocation(VkSystemAllocationScope const scope, uint8_t const typeIndex, uint64_t const size)
+{
+    scopeCounters[scope].allocations.fetch_add(1);
+    typeCounters[typeIndex].allocations.fetch_add(1);
+    addLiveBytes(scopeCounters[scope], size);
+    addLiveBytes(typeCounters[typeIndex], size);
+}
+
+void host_allocator::recordResize(VkSystemAllocationScope const scope, uint8_t const typeIndex, uint64_t const oldSize, uint64_t const newSize)
+{
+    scopeCounters[scope].reallocations.fetch_add(1);
+    typeCounters[typeIndex].reallocations.fetch_add(1);
+    addLiveBytes(scopeCounters[scope], newSize);
+    addLiveBytes(typeCounters[typeIndex], newSize);
+    scopeCounters[scope].liveBytes.fetch_sub(oldSize);
+    typeCounters[typeIndex].liveBytes.fetch_sub(oldSize);
+}
+
+void host_allocator::recordFree(VkSystemAllocationScope const scope, uint8_t const typeIndex, uint64_t const size)
+{
+    scopeCounters[scope].frees.fetch_add(1);
+    typeCounters[typeIndex].frees.fetch_add(1);
+    scopeCounters[scope].liveBytes.fetch_sub(size);
+    typeCounters[typeIndex].liveBytes.fetch_sub(size);
+}
+
+VKAPI_ATTR void* VKAPI_CALL host_allocator::allocationFunction(void* userData, size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+    object_type_binding* binding = static_cast<object_type_binding*>(userData);
+    return binding->owner->allocate(size, alignment, scope, binding->typeIndex);
+}
+
+VKAPI_ATTR void* VKAPI_CALL host_allocator::reallocationFunction(void* userData, void* original, size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+    object_type_binding* binding = static_cast<object_type_binding*>(userData);
+    return binding->owner->reallocate(original, size, alignment, scope, binding->typeIndex);
+}
+
+VKAPI_ATTR void VKAPI_CALL host_allocator::freeFunction(void* userData, void* memory)
+{
+    static_cast<object_type_binding*>(userData)->owner->release(memory);
+}
+
+VKAPI_ATTR void VKAPI_CALL host_allocator::internalAllocationNotification(void* userData, size_t size, VkInternalAllocationType, VkSystemAllocationScope)
+{
+    host_allocation_counters& counters = static_cast<object_type_binding*>(userData)->owner->internalCounters;
+    counters.allocations.fetch_add(1);
+    addLiveBytes(counters, size);
+}
+
+VKAPI_ATTR void VKAPI_CALL host_allocator::internalFreeNotification(void* userData, size_t size, VkInternalAllocationType, VkSystemAllocationScope)
+{
+    host_allocation_counters& counters = static_cast<object_type_binding*>(userData)->owner->internalCounters;
+    counters.frees.fetch_add(1);
+    counters.liveBytes.fetch_sub(size);
+}
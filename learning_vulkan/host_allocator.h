@@ -0,0 +1,87 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+constexpr uint32_t hostAllocatorSizeClassCount = 9;//16 bytes up to 4KiB in powers of two, anything bigger goes to malloc
+constexpr size_t hostAllocatorArenaBlockSize = 256 * 1024;
+constexpr uint32_t systemAllocationScopeCount = VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1;
+constexpr uint32_t trackedObjectTypeCount = 28;//the core object types plus surface and swapchain
+
+struct host_allocation_counters
+{
+    std::atomic<uint64_t> allocations{ 0 };
+    std::atomic<uint64_t> reallocations{ 0 };//resized in place, moves count as an allocation and a free
+    std::atomic<uint64_t> frees{ 0 };
+    std::atomic<uint64_t> liveBytes{ 0 };
+    std::atomic<uint64_t> peakBytes{ 0 };
+};
+
+//VkAllocationCallbacks backed by size class free lists carved out of large arena blocks.
+//the driver never says which object an allocation is for, so there is one set of callbacks
+//per object type and the type rides along in pUserData.
+class host_allocator
+{
+public:
+    explicit host_allocator(bool const enabled = true);
+    ~host_allocator();
+
+    host_allocator(host_allocator const&) = delete;
+    host_allocator& operator=(host_allocator const&) = delete;
+
+    //null when disabled so the driver falls back to its own allocator
+    VkAllocationCallbacks const* callbacks(VkObjectType const objectType) const;
+
+    uint64_t allocationCount() const;//allocations plus reallocations, across every scope
+    uint64_t liveBytes() const;
+
+    void writeReportJson(std::ostream& out) const;
+
+private:
+    struct object_type_binding
+    {
+        host_allocator* owner;
+        uint8_t typeIndex;
+        VkAllocationCallbacks callbacks;
+    };
+
+    struct size_class_pool
+    {
+        std::mutex lock;
+        void* freeList = nullptr;
+    };
+
+    void* allocate(size_t const size, size_t const alignment, VkSystemAllocationScope const scope, uint8_t const typeIndex);
+    void* reallocate(void* original, size_t const size, size_t const alignment, VkSystemAllocationScope const scope, uint8_t const typeIndex);
+    void release(void* memory);
+    void* takeBlock(uint32_t const sizeClass);
+    void* carveFromArena(size_t const blockSize);
+    void recordAllocation(VkSystemAllocationScope const scope, uint8_t const typeIndex, uint64_t const size);
+    void recordResize(VkSystemAllocationScope const scope, uint8_t const typeIndex, uint64_t const oldSize, uint64_t const newSize);
+    void recordFree(VkSystemAllocationScope const scope, uint8_t const typeIndex, uint64_t const size);
+
+    static VKAPI_ATTR void* VKAPI_CALL allocationFunction(void* userData, size_t size, size_t alignment, VkSystemAllocationScope scope);
+    static VKAPI_ATTR void* VKAPI_CALL reallocationFunction(void* userData, void* original, size_t size, size_t alignment, VkSystemAllocationScope scope);
+    static VKAPI_ATTR void VKAPI_CALL freeFunction(void* userData, void* memory);
+    static VKAPI_ATTR void VKAPI_CALL internalAllocationNotification(void* userData, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope);
+    static VKAPI_ATTR void VKAPI_CALL internalFreeNotification(void* userData, size_t size, VkInternalAllocationType type, VkSystemAllocationScope scope);
+
+    bool const enabled;
+    std::array<object_type_binding, trackedObjectTypeCount> bindings;
+    std::array<size_class_pool, hostAllocatorSizeClassCount> pools;
+
+    mutable std::mutex arenaLock;
+    std::vector<void*> arenaBlocks;
+    char* arenaCursor = nullptr;
+    size_t arenaRemaining = 0;
+
+    std::array<host_allocation_counters, systemAllocationScopeCount> scopeCounters;
+    std::array<host_allocation_counters, trackedObjectTypeCount> typeCounters;
+    host_allocation_counters internalCounters;//memory the driver allocated itself and only told us about
+};
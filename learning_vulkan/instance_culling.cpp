@@ -0,0 +1,404 @@
+#include "instance_culling.h"
+#include <cmath>
+#include <random>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CULL_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define CULL_TARGET_AVX2
+#else
+#include <cpuid.h>
+//gcc and clang only emit avx for functions that ask for it, msvc takes intrinsics anywhere
+#define CULL_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+float4x4 multiply(float4x4 const& left, float4x4 const& right)
+{
+    float4x4 reply;
+    for(uint32_t column = 0; column < 4; ++column)
+    {
+        for(uint32_t row = 0; row < 4; ++row)
+        {
+            float sum = 0.0f;
+            for(uint32_t k = 0; k < 4; ++k)
+            {
+                sum += left.m[k * 4 + row] * right.m[column * 4 + k];
+            }
+            reply.m[column * 4 + row] = sum;
+        }
+    }
+    return reply;
+}
+
+float4x4 perspective(float const verticalFieldOfView, float const aspect, float const nearPlane, float const farPlane)
+{
+    float const focalLength = 1.0f / std::tan(verticalFieldOfView / 2.0f);
+    float4x4 reply;
+    reply.m[0] = focalLength / aspect;
+    reply.m[5] = -focalLength;//vulkan's y points down
+    reply.m[10] = farPlane / (nearPlane - farPlane);
+    reply.m[11] = -1.0f;
+    reply.m[14] = nearPlane * farPlane / (nearPlane - farPlane);
+    return reply;
+}
+
+float4x4 lookAt(std::array<float, 3> const& eye, std::array<float, 3> const& target, std::array<float, 3> const& up)
+{
+    auto const normalise = [](std::array<float, 3> const& v)
+    {
+        float const length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+        return std::array<float, 3>{ v[0] / length, v[1] / length, v[2] / length };
+    };
+    auto const cross = [](std::array<float, 3> const& a, std::array<float, 3> const& b)
+    {
+        return std::array<float, 3>{ a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] };
+    };
+    auto const dot = [](std::array<float, 3> const& a, std::array<float, 3> const& b)
+    {
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    };
+    std::array<float, 3> const forward = normalise({ target[0] - eye[0], target[1] - eye[1], target[2] - eye[2] });
+    std::array<float, 3> const side = normalise(cross(forward, up));
+    std::array<float, 3> const cameraUp = cross(side, forward);
+
+    float4x4 reply;
+    for(uint32_t i = 0; i < 3; ++i)
+    {
+        reply.m[i * 4 + 0] = side[i];
+        reply.m[i * 4 + 1] = cameraUp[i];
+        reply.m[i * 4 + 2] = -forward[i];
+    }
+    reply.m[12] = -dot(side, eye);
+    reply.m[13] = -dot(cameraUp, eye);
+    reply.m[14] = dot(forward, eye);
+    reply.m[15] = 1.0f;
+    return reply;
+}
+
+frustum_planes extractFrustumPlanes(float4x4 const& viewProjection)
+{
+    //rows of the matrix combined as in gribb and hartmann, with 0 <= z <= w for the depth planes
+    auto const row = [&](uint32_t const index)
+    {
+        return std::array<float, 4>{ viewProjection.m[index], viewProjection.m[4 + index], viewProjection.m[8 + index], viewProjection.m[12 + index] };
+    };
+    std::array<float, 4> const x = row(0);
+    std::array<float, 4> const y = row(1);
+    std::array<float, 4> const z = row(2);
+    std::array<float, 4> const w = row(3);
+    std::array<std::array<float, 4>, 6> const planes =
+    { {
+        { w[0] + x[0], w[1] + x[1], w[2] + x[2], w[3] + x[3] },
+        { w[0] - x[0], w[1] - x[1], w[2] - x[2], w[3] - x[3] },
+        { w[0] + y[0], w[1] + y[1], w[2] + y[2], w[3] + y[3] },
+        { w[0] - y[0], w[1] - y[1], w[2] - y[2], w[3] - y[3] },
+        z,
+        { w[0] - z[0], w[1] - z[1], w[2] - z[2], w[3] - z[3] },
+    } };
+
+    frustum_planes reply;
+    for(uint32_t i = 0; i < 6; ++i)
+    {
+        float const length = std::sqrt(planes[i][0] * planes[i][0] + planes[i][1] * planes[i][1] + planes[i][2] * planes[i][2]);
+        reply.x[i] = planes[i][0] / length;
+        reply.y[i] = planes[i][1] / length;
+        reply.z[i] = planes[i][2] / length;
+        reply.w[i] = planes[i][3] / length;
+    }
+    return reply;
+}
+
+bool sphereVisible(frustum_planes const& frustum, float const x, float const y, float const z, float const radius)
+{
+    for(uint32_t plane = 0; plane < 6; ++plane)
+    {
+        if(frustum.x[plane] * x + frustum.y[plane] * y + frustum.z[plane] * z + frustum.w[plane] < -radius)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+instance_scene createInstanceScene(uint32_t const count, uint32_t const seed)
+{
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+    std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    instance_scene reply;
+    reply.centerX.reserve(count);
+    reply.centerY.reserve(count);
+    reply.centerZ.reserve(count);
+    reply.radius.reserve(count);
+    reply.models.reserve(count);
+    reply.colors.reserve(count);
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        float const x = position(random);
+        float const y = position(random);
+        float const z = position(random);
+        float const s = scale(random);
+        float const yaw = angle(random);
+        float const pitch = angle(random);
+
+        //scale, then pitch about x, then yaw about y, then translate
+        float4x4 model;
+        float const cy = std::cos(yaw), sy = std::sin(yaw), cp = std::cos(pitch), sp = std::sin(pitch);
+        model.m = { s * cy, 0.0f, -s * sy, 0.0f,
+            s * sy * sp, s * cp, s * cy * sp, 0.0f,
+            s * sy * cp, -s * sp, s * cy * cp, 0.0f,
+            x, y, z, 1.0f };
+
+        reply.centerX.push_back(x);
+        reply.centerY.push_back(y);
+        reply.centerZ.push_back(z);
+        reply.radius.push_back(s * 0.75f);//the triangle's corners are at most 0.71 from its origin
+        reply.models.push_back(model);
+        reply.colors.push_back({ unit(random), unit(random), unit(random), 1.0f });
+    }
+    return reply;
+}
+
+namespace
+{
+    void writeInstanceScalar(instance_gpu_data& out, float4x4 const& viewProjection, float4x4 const& model, std::array<float, 4> const& color)
+    {
+        float4x4 const transform = multiply(viewProjection, model);
+        for(uint32_t i = 0; i < 16; ++i)
+        {
+            out.transform[i] = transform.m[i];
+        }
+        for(uint32_t i = 0; i < 4; ++i)
+        {
+            out.color[i] = color[i];
+        }
+    }
+
+    uint32_t cullScalar(instance_scene const& scene, frustum_planes const& frustum, float4x4 const& viewProjection, instance_gpu_data* out)
+    {
+        uint32_t visible = 0;
+        for(uint32_t i = 0; i < scene.size(); ++i)
+        {
+            if(sphereVisible(frustum, scene.centerX[i], scene.centerY[i], scene.centerZ[i], scene.radius[i]))
+            {
+                writeInstanceScalar(out[visible++], viewProjection, scene.models[i], scene.colors[i]);
+            }
+        }
+        return visible;
+    }
+
+#ifdef CULL_X86
+    uint32_t lowestSetBit(uint32_t const bits)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, bits);
+        return index;
+#else
+        return static_cast<uint32_t>(__builtin_ctz(bits));
+#endif
+    }
+
+    //a column of the result is the view projection's columns weighted by the model's column
+    void writeInstanceSse(instance_gpu_data& out, __m128 const (&viewProjection)[4], float4x4 const& model, std::array<float, 4> const& color)
+    {
+        for(uint32_t column = 0; column < 4; ++column)
+        {
+            float const* const modelColumn = &model.m[column * 4];
+            __m128 result = _mm_mul_ps(viewProjection[0], _mm_set1_ps(modelColumn[0]));
+            result = _mm_add_ps(result, _mm_mul_ps(viewProjection[1], _mm_set1_ps(modelColumn[1])));
+            result = _mm_add_ps(result, _mm_mul_ps(viewProjection[2], _mm_set1_ps(modelColumn[2])));
+            result = _mm_add_ps(result, _mm_mul_ps(viewProjection[3], _mm_set1_ps(modelColumn[3])));
+            _mm_storeu_ps(&out.transform[column * 4], result);
+        }
+        _mm_storeu_ps(out.color, _mm_loadu_ps(color.data()));
+    }
+
+    uint32_t cullSse(instance_scene const& scene, frustum_planes const& frustum, float4x4 const& viewProjection, instance_gpu_data* out)
+    {
+        __m128 const viewProjectionColumns[4] =
+        {
+            _mm_loadu_ps(&viewProjection.m[0]),
+            _mm_loadu_ps(&viewProjection.m[4]),
+            _mm_loadu_ps(&viewProjection.m[8]),
+            _mm_loadu_ps(&viewProjection.m[12]),
+        };
+        __m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+        for(uint32_t plane = 0; plane < 6; ++plane)
+        {
+            planeX[plane] = _mm_set1_ps(frustum.x[plane]);
+            planeY[plane] = _mm_set1_ps(frustum.y[plane]);
+            planeZ[plane] = _mm_set1_ps(frustum.z[plane]);
+            planeW[plane] = _mm_set1_ps(frustum.w[plane]);
+        }
+
+        uint32_t visible = 0;
+        uint32_t const count = scene.size();
+        uint32_t i = 0;
+        for(; i + 4 <= count; i += 4)
+        {
+            __m128 const x = _mm_loadu_ps(&scene.centerX[i]);
+            __m128 const y = _mm_loadu_ps(&scene.centerY[i]);
+            __m128 const z = _mm_loadu_ps(&scene.centerZ[i]);
+            __m128 const negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&scene.radius[i]));
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for(uint32_t plane = 0; plane < 6; ++plane)
+            {
+                __m128 distance = _mm_add_ps(_mm_mul_ps(planeX[plane], x), planeW[plane]);
+                distance = _mm_add_ps(distance, _mm_mul_ps(planeY[plane], y));
+                distance = _mm_add_ps(distance, _mm_mul_ps(planeZ[plane], z));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+            }
+            for(uint32_t bits = static_cast<uint32_t>(_mm_movemask_ps(inside)); bits; bits &= bits - 1)
+            {
+                uint32_t const index = i + lowestSetBit(bits);
+                writeInstanceSse(out[visible++], viewProjectionColumns, scene.models[index], scene.colors[index]);
+            }
+        }
+        for(; i < count; ++i)
+        {
+            if(sphereVisible(frustum, scene.centerX[i], scene.centerY[i], scene.centerZ[i], scene.radius[i]))
+            {
+                writeInstanceSse(out[visible++], viewProjectionColumns, scene.models[i], scene.colors[i]);
+            }
+        }
+        return visible;
+    }
+
+    //two result columns per register. kept separate from the sse writer because calling legacy sse
+    //code with the upper ymm halves dirty stalls on every transition.
+    CULL_TARGET_AVX2 void writeInstanceAvx2(instance_gpu_data& out, __m256 const (&viewProjection)[4], float4x4 const& model, std::array<float, 4> const& color)
+    {
+        for(uint32_t column = 0; column < 4; column += 2)
+        {
+            float const* const modelColumns = &model.m[column * 4];
+            __m256 result = _mm256_mul_ps(viewProjection[0], _mm256_setr_m128(_mm_set1_ps(modelColumns[0]), _mm_set1_ps(modelColumns[4])));
+            result = _mm256_fmadd_ps(viewProjection[1], _mm256_setr_m128(_mm_set1_ps(modelColumns[1]), _mm_set1_ps(modelColumns[5])), result);
+            result = _mm256_fmadd_ps(viewProjection[2], _mm256_setr_m128(_mm_set1_ps(modelColumns[2]), _mm_set1_ps(modelColumns[6])), result);
+            result = _mm256_fmadd_ps(viewProjection[3], _mm256_setr_m128(_mm_set1_ps(modelColumns[3]), _mm_set1_ps(modelColumns[7])), result);
+            _mm256_storeu_ps(&out.transform[column * 4], result);
+        }
+        _mm_storeu_ps(out.color, _mm_loadu_ps(color.data()));
+    }
+
+    CULL_TARGET_AVX2 uint32_t cullAvx2(instance_scene const& scene, frustum_planes const& frustum, float4x4 const& viewProjection, instance_gpu_data* out)
+    {
+        __m256 viewProjectionColumns[4];
+        for(uint32_t column = 0; column < 4; ++column)
+        {
+            __m128 const values = _mm_loadu_ps(&viewProjection.m[column * 4]);
+            viewProjectionColumns[column] = _mm256_setr_m128(values, values);
+        }
+        __m256 planeX[6], planeY[6], planeZ[6], planeW[6];
+        for(uint32_t plane = 0; plane < 6; ++plane)
+        {
+            planeX[plane] = _mm256_set1_ps(frustum.x[plane]);
+            planeY[plane] = _mm256_set1_ps(frustum.y[plane]);
+            planeZ[plane] = _mm256_set1_ps(frustum.z[plane]);
+            planeW[plane] = _mm256_set1_ps(frustum.w[plane]);
+        }
+
+        uint32_t visible = 0;
+        uint32_t const count = scene.size();
+        uint32_t i = 0;
+        for(; i + 8 <= count; i += 8)
+        {
+            __m256 const x = _mm256_loadu_ps(&scene.centerX[i]);
+            __m256 const y = _mm256_loadu_ps(&scene.centerY[i]);
+            __m256 const z = _mm256_loadu_ps(&scene.centerZ[i]);
+            __m256 const negativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(&scene.radius[i]));
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for(uint32_t plane = 0; plane < 6; ++plane)
+            {
+                __m256 distance = _mm256_fmadd_ps(planeX[plane], x, planeW[plane]);
+                distance = _mm256_fmadd_ps(planeY[plane], y, distance);
+                distance = _mm256_fmadd_ps(planeZ[plane], z, distance);
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negativeRadius, _CMP_GE_OQ));
+            }
+            //most of a block is usually culled together, skip straight past empty ones
+            for(uint32_t bits = static_cast<uint32_t>(_mm256_movemask_ps(inside)); bits; bits &= bits - 1)
+            {
+                uint32_t const index = i + lowestSetBit(bits);
+                writeInstanceAvx2(out[visible++], viewProjectionColumns, scene.models[index], scene.colors[index]);
+            }
+        }
+        for(; i < count; ++i)
+        {
+            if(sphereVisible(frustum, scene.centerX[i], scene.centerY[i], scene.centerZ[i], scene.radius[i]))
+            {
+                writeInstanceAvx2(out[visible++], viewProjectionColumns, scene.models[i], scene.colors[i]);
+            }
+        }
+        return visible;
+    }
+
+    bool cpuSupportsAvx2()
+    {
+        uint32_t leaf1Ecx = 0;
+        uint32_t leaf7Ebx = 0;
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        if(info[0] < 7)
+        {
+            return false;
+        }
+        __cpuid(info, 1);
+        leaf1Ecx = static_cast<uint32_t>(info[2]);
+        __cpuidex(info, 7, 0);
+        leaf7Ebx = static_cast<uint32_t>(info[1]);
+#else
+        unsigned int eax, ebx, ecx, edx;
+        if(__get_cpuid_max(0, nullptr) < 7 || !__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        {
+            return false;
+        }
+        leaf1Ecx = ecx;
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+        leaf7Ebx = ebx;
+#endif
+        bool const osSavesYmm = (leaf1Ecx & (1u << 27)) != 0;//osxsave
+        bool const avx = (leaf1Ecx & (1u << 28)) != 0;
+        bool const fma = (leaf1Ecx & (1u << 12)) != 0;
+        bool const avx2 = (leaf7Ebx & (1u << 5)) != 0;
+        if(!osSavesYmm || !avx || !fma || !avx2)
+        {
+            return false;
+        }
+        //the cpu having avx is not enough, the os has to save the ymm registers on a context switch
+#if defined(_MSC_VER)
+        uint64_t const enabledState = _xgetbv(0);
+#else
+        uint32_t stateLow, stateHigh;
+        __asm__("xgetbv" : "=a"(stateLow), "=d"(stateHigh) : "c"(0));
+        uint64_t const enabledState = (static_cast<uint64_t>(stateHigh) << 32) | stateLow;
+#endif
+        return (enabledState & 0x6) == 0x6;
+    }
+#endif
+}
+
+std::vector<cull_kernel> supportedCullKernels()
+{
+    std::vector<cull_kernel> reply = { { "scalar", cullScalar } };
+#ifdef CULL_X86
+    //sse2 is part of x86-64 and every x86 cpu vulkan runs on
+    reply.push_back({ "sse", cullSse });
+    if(cpuSupportsAvx2())
+    {
+        reply.push_back({ "avx2", cullAvx2 });
+    }
+#endif
+    return reply;
+}
+
+cull_kernel selectCullKernel()
+{
+    return supportedCullKernels().back();
+}
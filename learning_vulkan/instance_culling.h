@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+//column major, the layout glsl reads a mat4 vertex attribute in
+struct float4x4
+{
+    std::array<float, 16> m{};
+};
+
+float4x4 multiply(float4x4 const& left, float4x4 const& right);
+
+//vulkan clip space: y down and depth from 0 to 1
+float4x4 perspective(float const verticalFieldOfView, float const aspect, float const nearPlane, float const farPlane);
+
+float4x4 lookAt(std::array<float, 3> const& eye, std::array<float, 3> const& target, std::array<float, 3> const& up);
+
+//normalised so a plane test gives a signed distance. soa so a kernel can splat one plane at a time.
+struct frustum_planes
+{
+    std::array<float, 6> x;
+    std::array<float, 6> y;
+    std::array<float, 6> z;
+    std::array<float, 6> w;
+};
+
+frustum_planes extractFrustumPlanes(float4x4 const& viewProjection);
+
+//false only when the sphere is wholly outside one of the planes
+bool sphereVisible(frustum_planes const& frustum, float const x, float const y, float const z, float const radius);
+
+//bounding spheres in structure of arrays form so the kernels load 4 or 8 of each at once. the
+//models and colours are only touched for the instances that survive.
+struct instance_scene
+{
+    std::vector<float> centerX;
+    std::vector<float> centerY;
+    std::vector<float> centerZ;
+    std::vector<float> radius;
+    std::vector<float4x4> models;
+    std::vector<std::array<float, 4>> colors;
+
+    uint32_t size() const { return static_cast<uint32_t>(radius.size()); }
+};
+
+//count instances scattered through a cube, each a small triangle with a random orientation
+instance_scene createInstanceScene(uint32_t const count, uint32_t const seed);
+
+//what the instanced pipeline reads per instance, clip space transform already applied
+struct instance_gpu_data
+{
+    float transform[16];
+    float color[4];
+};
+
+//tests every instance against the frustum and writes the survivors, transformed by viewProjection,
+//straight into out. returns how many were written.
+using cull_kernel_function = uint32_t(*)(instance_scene const& scene,
+    frustum_planes const& frustum,
+    float4x4 const& viewProjection,
+    instance_gpu_data* out);
+
+struct cull_kernel
+{
+    char const* name;
+    cull_kernel_function function;
+};
+
+//scalar always, then sse and avx2 where the cpu and os support them
+std::vector<cull_kernel> supportedCullKernels();
+
+//the widest kernel this machine can run
+cull_kernel selectCullKernel();
@@ -1,38 +1,96 @@
-#include "vulkan_init.h"
+#include "frame_handoff.h"
+#include "presentation_target.h"
+#include "render_farm.h"
+#include "texture_stream.h"
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <string>
+#include <thread>
+
+struct application_options
+{
+    std::string meshFileName;
+    uint32_t meshCopiesPerSide = 1;
+    float meshPixelError = meshLodDefaultPixelError;//0 always draws the full detail
+    vector<std::string> textureFileNames;
+    VkDeviceSize textureBudget = textureDefaultBudget;
+    uint32_t textureDemandCycleFrames = 0;//0 asks for every texture at the window's size
+    uint32_t instanceCount = 0;
+    double targetFrameMilliseconds = 0.0;//gpu budget for dynamic resolution, 0 renders at full size
+    uint32_t particleCount = 0;
+    uint32_t particleBenchmarkFrames = 0;//frames measured per particle count, 0 doesn't sweep
+    uint32_t hudScale = 0;//screen pixels per hud atlas pixel, 0 draws no hud
+};
+
+//sweeps the live particle count up to the system's capacity, timing frames and compute steps at each
+struct particle_benchmark
+{
+    uint32_t framesPerCount = 0;//0 when not benchmarking
+    uint32_t frames = 0;
+    std::chrono::steady_clock::time_point start;
+    double computeMilliseconds = 0.0;
+    uint32_t computeSamples = 0;
+};
 
 class HelloTriangleApplication {
-	GLFWwindow* window;
+    host_allocator hostAllocator;//first so it outlives every object created through it
     VkInstance vulkanInstance;
     VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
     VkDevice logicalDevice;
     VkQueue graphicsQueue;
     VkQueue presentationQueue;
-    
-    VkSurfaceKHR surface;
-    VkSwapchainKHR swapChain;
-    image_list swapChainImages;
-    VkFormat swapChainImageFormat;
-    VkExtent2D swapChainExtent;
-    image_views swapChainImageViews;
-    VkPipeline graphicsPipeline;
-    VkRenderPass renderPass;
-    VkPipelineLayout pipelineLayout;
-    vector<VkFramebuffer> swapChainFramebuffers;
+    queue_family_index_t presentationQueueFamily;
+
+    vector<presentation_target> targets;
 
     VkCommandPool commandPool;
-    vector<VkCommandBuffer> commandBuffers;
 
-    vector<VkSemaphore> imageAvailableSemaphores;
+    std::optional<streamed_mesh> mesh;
+    mesh_field meshField;
+    float meshPixelError = meshLodDefaultPixelError;
+    std::optional<texture_streamer> textures;
+    uint32_t textureDemandCycleFrames = 0;
+    std::optional<particle_system> particles;
+    uint32_t particleCount = 0;
+    particle_benchmark particleBenchmark;
+    std::optional<hud_atlas> hud;
+    uint32_t hudScale = 0;
+    frame_timings frameTimings;//kept with or without a hud
+    std::chrono::steady_clock::time_point lastFrameStart;
+    instance_scene instances;
+    cull_kernel cullKernel = selectCullKernel();
+
     vector<VkSemaphore> renderFinishedSemaphores;
     vector<VkFence> inFlightFences;
-    vector<VkFence> imagesInFlight;
     size_t currentFrame = 0;
 
+    //scratch for the single batched submit and present, sized once so the frame loop never allocates
+    vector<VkSemaphore> frameWaitSemaphores;
+    vector<VkPipelineStageFlags> frameWaitStages;
+    vector<VkCommandBuffer> frameCommandBuffers;
+    vector<VkSwapchainKHR> frameSwapChains;
+    vector<uint32_t> frameImageIndices;
+    vector<VkResult> framePresentResults;
+
+    VkPhysicalDeviceFeatures enabledFeatures{};
+    bool memoryBudgetEnabled = false;
+    uint64_t frameNumber = 0;
+    uint64_t warmupHostAllocations = 0;
+
+    //the window thread polls events and publishes snapshots, the render thread owns every vulkan call after init
+    triple_buffer<frame_snapshot> snapshots;
+    std::atomic<bool> stopRendering{ false };
+    std::atomic<bool> renderStopped{ false };
+    std::exception_ptr renderFailure;
+    std::thread renderThread;
+    std::array<bool, chunkToggleKeyCount> chunkToggleKeysHeld{};//window thread only
+
 public:
-	HelloTriangleApplication() : window(glfwCreateWindow(800, 600, "Vulkan", nullptr, nullptr))
+	HelloTriangleApplication(application_options const& options)
     {
         initWindow();
-        initVulkan();
+        initVulkan(options);
         mainLoop();
     }
 
@@ -40,78 +98,215 @@ public:
     {
         for(VkSemaphore const& semaphore : renderFinishedSemaphores)
         {
-            vkDestroySemaphore(logicalDevice, semaphore, nullptr);
+            vkDestroySemaphore(logicalDevice, semaphore, hostAllocator.callbacks(VK_OBJECT_TYPE_SEMAPHORE));
+        }
+        for(VkFence const& fence : inFlightFences)
+        {
+            vkDestroyFence(logicalDevice, fence, hostAllocator.callbacks(VK_OBJECT_TYPE_FENCE));
         }
-        for(VkSemaphore const& semaphore : imageAvailableSemaphores)
+        for(presentation_target& target : targets)
         {
-            vkDestroySemaphore(logicalDevice, semaphore, nullptr);
+            destroyTargetSemaphores(target, logicalDevice, hostAllocator);
+            destroySwapChainResources(target, logicalDevice, hostAllocator);
         }
-        for(VkFence const& fence : inFlightFences)
+        if(mesh)
         {
-            vkDestroyFence(logicalDevice, fence, nullptr);
+            destroyStreamedMesh(*mesh, logicalDevice, hostAllocator);
         }
-        vkDestroyCommandPool(logicalDevice, commandPool, nullptr);
-        for(VkFramebuffer const& framebuffer : swapChainFramebuffers)
+        textures.reset();
+        if(particles)
         {
-            vkDestroyFramebuffer(logicalDevice, framebuffer, nullptr);
+            destroyParticleSystem(*particles, logicalDevice, hostAllocator);
         }
-        vkDestroyPipeline(logicalDevice, graphicsPipeline, nullptr);
-        vkDestroyPipelineLayout(logicalDevice, pipelineLayout, nullptr);
-        vkDestroyRenderPass(logicalDevice, renderPass, nullptr);
-        for(VkImageView const& imageView : swapChainImageViews)
+        if(hud)
         {
-            vkDestroyImageView(logicalDevice, imageView, nullptr);
+            destroyHudAtlas(*hud, logicalDevice, hostAllocator);
+        }
+        vkDestroyCommandPool(logicalDevice, commandPool, hostAllocator.callbacks(VK_OBJECT_TYPE_COMMAND_POOL));
+        vkDestroyDevice(logicalDevice, hostAllocator.callbacks(VK_OBJECT_TYPE_DEVICE));
+        for(presentation_target const& target : targets)
+        {
+            vkDestroySurfaceKHR(vulkanInstance, target.surface, hostAllocator.callbacks(VK_OBJECT_TYPE_SURFACE_KHR));
+        }
+        vkDestroyInstance(vulkanInstance, hostAllocator.callbacks(VK_OBJECT_TYPE_INSTANCE));
+        for(presentation_target const& target : targets)
+        {
+            glfwDestroyWindow(target.window);
         }
-        vkDestroySwapchainKHR(logicalDevice, swapChain, nullptr);
-        vkDestroyDevice(logicalDevice, nullptr);
-        vkDestroySurfaceKHR(vulkanInstance, surface, nullptr);
-        vkDestroyInstance(vulkanInstance, nullptr);
-        glfwDestroyWindow(window);
         glfwTerminate();
+        hostAllocator.writeReportJson(std::cout);
 	}
 
 private:
-	void initVulkan() {
-        vulkanInstance = createInstance();
-        surface = createSurface(vulkanInstance, window);
-        physicalDevice = pickPhysicalDevice(vulkanInstance, surface, queueRequirements, requiredExtensions);
+	void initVulkan(application_options const& options) {
+        vulkanInstance = createInstance(hostAllocator, true);
+        for(presentation_target& target : targets)
+        {
+            target.surface = createSurface(vulkanInstance, target.window, hostAllocator);
+        }
+        //the first surface picks the device, the rest have to be presentable from the same queue
+        physicalDevice = pickPhysicalDevice(vulkanInstance, targets.front().surface, queueRequirements, requiredExtensions);
         
-        auto const[logicalDeviceResult, graphicsQueueIndex, presentationQueueIndex] = createLogicalDevice(physicalDevice, surface, queueRequirements, requiredExtensions);
+        VkPhysicalDeviceFeatures supportedFeatures;
+        vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+        enabledFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
+        enabledFeatures.occlusionQueryPrecise = supportedFeatures.occlusionQueryPrecise;
+        enabledFeatures.inheritedQueries = supportedFeatures.inheritedQueries;
+
+        vector<char const*> deviceExtensions = requiredExtensions;
+        memoryBudgetEnabled = checkDeviceExtensionSupport(physicalDevice, { VK_EXT_MEMORY_BUDGET_EXTENSION_NAME });
+        if(memoryBudgetEnabled)
+        {
+            deviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        }
+
+        auto const[logicalDeviceResult, graphicsQueueIndex, presentationQueueIndex, computeQueueIndex] = createLogicalDevice(physicalDevice, targets.front().surface, queueRequirements, deviceExtensions, enabledFeatures, hostAllocator);
         logicalDevice = logicalDeviceResult;
+        presentationQueueFamily = presentationQueueIndex;
         vkGetDeviceQueue(logicalDevice, graphicsQueueIndex, 0, &graphicsQueue);
         vkGetDeviceQueue(logicalDevice, presentationQueueIndex, 0, &presentationQueue);
-        
-        swap_chain_support_details swapChainSupport = querySwapChainSupport(physicalDevice, surface);
-        swapChain = createSwapChain(swapChainSupport, surface, physicalDevice, logicalDevice);
-        uint32_t imageCount;
-        vkGetSwapchainImagesKHR(logicalDevice, swapChain, &imageCount, nullptr);
-        swapChainImages.resize(imageCount);
-        vkGetSwapchainImagesKHR(logicalDevice, swapChain, &imageCount, swapChainImages.data());
-        swapChainImageFormat = chooseSwapSurfaceFormat(swapChainSupport.formats).format;
-        swapChainExtent = chooseSwapExtent(swapChainSupport.capabilities);
-        swapChainImageViews = createImageViews(swapChainImages, swapChainImageFormat, logicalDevice);
-
-        renderPass = createRenderPass(logicalDevice, swapChainImageFormat);
-        auto const[graphicsPipelineResult, pipelineLayoutResult] = createGraphicsPipeline(logicalDevice, swapChainExtent, renderPass);
-        graphicsPipeline = graphicsPipelineResult;
-        pipelineLayout = pipelineLayoutResult;
-
-        swapChainFramebuffers = createFreamebuffers(logicalDevice, swapChainImageViews, renderPass, swapChainExtent);
-
-        commandPool = createCommandPool(logicalDevice, graphicsQueueIndex);
-        commandBuffers = createCommandBuffers(logicalDevice, commandPool, swapChainFramebuffers.size(), renderPass, swapChainFramebuffers, swapChainExtent, graphicsPipeline);
+        for(presentation_target const& target : targets)
+        {
+            VkBool32 supportsPresentation = false;
+            vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, presentationQueueFamily, target.surface, &supportsPresentation);
+            if(!supportsPresentation)
+            {
+                throw std::runtime_error("Not every window can be presented from the same queue.");
+            }
+        }
+
+        //chunks are re-recorded one command buffer at a time
+        commandPool = createCommandPool(logicalDevice, graphicsQueueIndex, hostAllocator, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+        if(!options.meshFileName.empty())
+        {
+            mesh.emplace();
+            openStreamedMesh(*mesh, options.meshFileName, physicalDevice, logicalDevice, graphicsQueueIndex, hostAllocator);
+            meshField = createMeshField(mesh->header, options.meshCopiesPerSide);
+            meshPixelError = options.meshPixelError;
+        }
+        if(!options.textureFileNames.empty())
+        {
+            textures.emplace(physicalDevice, logicalDevice, graphicsQueueIndex, options.textureBudget, hostAllocator);
+            for(std::string const& textureFileName : options.textureFileNames)
+            {
+                textures->load(textureFileName);
+            }
+            textureDemandCycleFrames = options.textureDemandCycleFrames;
+        }
+        if(options.particleCount > 0 || options.particleBenchmarkFrames > 0)
+        {
+            uint32_t const capacity = options.particleCount > 0 ? options.particleCount : particleBenchmarkMaximumCount;
+            particles.emplace();
+            createParticleSystem(*particles, capacity, physicalDevice, logicalDevice, graphicsQueueIndex, computeQueueIndex, hostAllocator);
+            particleBenchmark.framesPerCount = options.particleBenchmarkFrames;
+            particleCount = particleBenchmark.framesPerCount > 0 ? std::min(particleBenchmarkMinimumCount, capacity) : capacity;
+        }
+        if(options.hudScale > 0)
+        {
+            hud.emplace();
+            createHudAtlas(*hud, physicalDevice, logicalDevice, graphicsQueue, commandPool, hostAllocator);
+            hudScale = options.hudScale;
+        }
+        instances = createInstanceScene(options.instanceCount, 1);
+        for(presentation_target& target : targets)
+        {
+            //every target draws in the same submission, so they split the budget
+            target.resolution = resolution_controller(options.targetFrameMilliseconds / targets.size());
+            createSwapChainResources(target, physicalDevice, logicalDevice, commandPool, enabledFeatures, mesh ? &*mesh : nullptr, meshField.size(), instances.size(), particles ? &*particles : nullptr, hud ? &*hud : nullptr, options.targetFrameMilliseconds > 0.0, hostAllocator);
+            createTargetSemaphores(target, logicalDevice, hostAllocator);
+        }
         createSemaphores();
+
+        frameWaitSemaphores.resize(targets.size() + 1);//the last is the particle step, the draws only need it at vertex input
+        frameWaitStages.assign(targets.size(), VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+        frameWaitStages.push_back(VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+        frameCommandBuffers.resize(targets.size() + 2);//room for the mesh and texture uploads ahead of the draws
+        frameSwapChains.resize(targets.size());
+        frameImageIndices.resize(targets.size());
+        framePresentResults.resize(targets.size());
 	}
 
+    //glfw wants its events pumped on the main thread, so that stays here and the frames move to
+    //their own thread. a long fence wait or acquire no longer stalls input, and a burst of
+    //events or a window drag no longer stalls frames.
     void mainLoop() {
-        while(!glfwWindowShouldClose(window))
+        renderThread = std::thread(&HelloTriangleApplication::renderLoop, this);
+        frame_snapshot snapshot;
+        auto const start = std::chrono::steady_clock::now();
+        while(!anyWindowShouldClose() && !renderStopped.load(std::memory_order_acquire))
         {
-            glfwPollEvents();
-            drawFrame();
+            glfwWaitEventsTimeout(inputPollSeconds);
+            double const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            updateCamera(snapshot, static_cast<float>(seconds - snapshot.seconds));
+            updateHiddenChunks(snapshot);
+            snapshot.seconds = seconds;
+            ++snapshot.sequence;
+            snapshots.writeSlot() = snapshot;
+            snapshots.publish();
+        }
+        stopRendering.store(true, std::memory_order_release);
+        renderThread.join();
+        if(renderFailure)
+        {
+            std::rethrow_exception(renderFailure);
         }
-        vkDeviceWaitIdle(logicalDevice);
 	}
 
+    void renderLoop()
+    {
+        try
+        {
+            while(!stopRendering.load(std::memory_order_acquire))
+            {
+                //when the window thread hasn't published since last frame the previous snapshot is reused
+                snapshots.acquire();
+                drawFrame(snapshots.readSlot());
+            }
+        }
+        catch(...)
+        {
+            renderFailure = std::current_exception();
+        }
+        vkDeviceWaitIdle(logicalDevice);
+        renderStopped.store(true, std::memory_order_release);
+        glfwPostEmptyEvent();//wake the window thread so it notices
+    }
+
+    void updateCamera(frame_snapshot& snapshot, float const elapsedSeconds)
+    {
+        auto const keyHeld = [&](int const key)
+        {
+            return std::any_of(begin(targets), end(targets), [&](presentation_target const& target)
+            {
+                return glfwGetKey(target.window, key) == GLFW_PRESS;
+            });
+        };
+        float const turn = static_cast<float>(keyHeld(GLFW_KEY_RIGHT)) - static_cast<float>(keyHeld(GLFW_KEY_LEFT));
+        float const tilt = static_cast<float>(keyHeld(GLFW_KEY_UP)) - static_cast<float>(keyHeld(GLFW_KEY_DOWN));
+        float const zoom = static_cast<float>(keyHeld(GLFW_KEY_S)) - static_cast<float>(keyHeld(GLFW_KEY_W));
+
+        snapshot.cameraYaw += elapsedSeconds * (turn != 0.0f || tilt != 0.0f ? cameraTurnSpeed * turn : cameraOrbitSpeed);
+        snapshot.cameraPitch = std::clamp(snapshot.cameraPitch + elapsedSeconds * cameraTurnSpeed * tilt, -1.5f, 1.5f);
+        snapshot.cameraDistance = std::clamp(snapshot.cameraDistance + elapsedSeconds * cameraZoomSpeed * zoom, 5.0f, 250.0f);
+    }
+
+    //toggles on the press rather than while held
+    void updateHiddenChunks(frame_snapshot& snapshot)
+    {
+        for(uint32_t chunk = 0; chunk < chunkToggleKeyCount; ++chunk)
+        {
+            bool const held = std::any_of(begin(targets), end(targets), [&](presentation_target const& target)
+            {
+                return glfwGetKey(target.window, GLFW_KEY_1 + chunk) == GLFW_PRESS;
+            });
+            if(held && !chunkToggleKeysHeld[chunk])
+            {
+                snapshot.hiddenChunks ^= 1u << chunk;
+            }
+            chunkToggleKeysHeld[chunk] = held;
+        }
+    }
+
 	void initWindow()
 	{
 		glfwInit();
@@ -119,16 +314,25 @@ private:
         glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
 		glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
         
-        window = glfwCreateWindow(windowWidth, windowHeight, "Vulkan Window", nullptr, nullptr);
+        targets.resize(presentationTargetCount);
+        for(presentation_target& target : targets)
+        {
+            target.window = createPresentationWindow(static_cast<uint32_t>(&target - &targets[0]));
+        }
 	}
 
+    bool anyWindowShouldClose() const
+    {
+        return std::any_of(begin(targets), end(targets), [](presentation_target const& target)
+        {
+            return glfwWindowShouldClose(target.window);
+        });
+    }
 
     void createSemaphores()
     {
-        imageAvailableSemaphores.resize(maxFramesInFlight);
         renderFinishedSemaphores.resize(maxFramesInFlight);
         inFlightFences.resize(maxFramesInFlight);
-        imagesInFlight.resize(swapChainImages.size(), VK_NULL_HANDLE);
 
         VkSemaphoreCreateInfo semaphoreInfo{};
         semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -139,42 +343,144 @@ private:
 
         for(size_t i = 0; i < maxFramesInFlight; ++i)
         {
-            if(VK_FAILED(vkCreateSemaphore(logicalDevice, &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]))
-                || VK_FAILED(vkCreateSemaphore(logicalDevice, &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]))
-                || VK_FAILED(vkCreateFence(logicalDevice, &fenceInfo, nullptr, &inFlightFences[i])))
+            if(VK_FAILED(vkCreateSemaphore(logicalDevice, &semaphoreInfo, hostAllocator.callbacks(VK_OBJECT_TYPE_SEMAPHORE), &renderFinishedSemaphores[i]))
+                || VK_FAILED(vkCreateFence(logicalDevice, &fenceInfo, hostAllocator.callbacks(VK_OBJECT_TYPE_FENCE), &inFlightFences[i])))
             {
                 throw std::runtime_error("Failed to create semaphores.");
             }
         }
     }
 
-    void drawFrame()
+    //acquires from every swapchain, then one submit and one present cover all of them
+    void drawFrame(frame_snapshot const& snapshot)
     {
+        using milliseconds = std::chrono::duration<double, std::milli>;
+        auto const frameStart = std::chrono::steady_clock::now();
+        if(frameNumber > 0)
+        {
+            pushFrameTime(frameTimings, static_cast<float>(milliseconds(frameStart - lastFrameStart).count()));
+        }
+        lastFrameStart = frameStart;
+
         vkWaitForFences(logicalDevice, 1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
+        frameTimings.waitMilliseconds = milliseconds(std::chrono::steady_clock::now() - frameStart).count();
+        if(frameNumber == hostAllocationWarmupFrames)
+        {
+            //once warmed up the frame loop should not be asking the driver for host memory at all
+            warmupHostAllocations = hostAllocator.allocationCount();
+        }
 
-        uint32_t imageIndex;
-        vkAcquireNextImageKHR(logicalDevice, swapChain, UINT64_MAX, imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
+        //submitted ahead of the draws so the compute queue can get on with it while this thread records
+        uint32_t waitSemaphoreCount = static_cast<uint32_t>(targets.size());
+        if(particles)
+        {
+            frameWaitSemaphores[waitSemaphoreCount++] = stepParticleFrame();
+        }
 
-        if(imagesInFlight[imageIndex] != VK_NULL_HANDLE)
+        //the upload goes first in the submission so its barrier covers every target's draws
+        VkCommandBuffer const meshUpload = mesh ? streamMeshChunk(*mesh, logicalDevice, static_cast<uint32_t>(currentFrame)) : VK_NULL_HANDLE;
+        uint32_t commandBufferCount = 0;
+        if(meshUpload != VK_NULL_HANDLE)
         {
-            vkWaitForFences(logicalDevice, 1, &imagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
+            frameCommandBuffers[commandBufferCount++] = meshUpload;
         }
-        imagesInFlight[imageIndex] = inFlightFences[currentFrame];
+        if(textures)
+        {
+            //nothing samples the textures yet, so demand is made up from the size of the first window
+            for(uint32_t textureIndex = 0; textureIndex < textures->textureCount(); ++textureIndex)
+            {
+                textures->requestExtent(textureIndex, textureDemandExtent(textureIndex, targets.front().swapChainExtent, frameNumber), frameNumber);
+            }
+            VkCommandBuffer const textureUpdate = textures->update(static_cast<uint32_t>(currentFrame), frameNumber);
+            if(textureUpdate != VK_NULL_HANDLE)
+            {
+                frameCommandBuffers[commandBufferCount++] = textureUpdate;
+            }
+            if(frameNumber % statsLogInterval == 0)
+            {
+                textures->writeReportJson(std::cout);
+            }
+        }
+
+        //summed over the targets and only stored once the frame is submitted, so the huds show the
+        //previous frame's phases
+        double acquireMilliseconds = 0.0;
+        double cullMilliseconds = 0.0;
+        double recordMilliseconds = 0.0;
+        double hudMilliseconds = 0.0;
+        for(presentation_target& target : targets)
+        {
+            size_t const targetIndex = &target - &targets[0];
+            uint32_t& imageIndex = target.acquiredImage;
+            auto const acquireStart = std::chrono::steady_clock::now();
+            vkAcquireNextImageKHR(logicalDevice, target.swapChain, UINT64_MAX, target.imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
+
+            if(target.imagesInFlight[imageIndex] != VK_NULL_HANDLE)
+            {
+                vkWaitForFences(logicalDevice, 1, &target.imagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
+                //the previous submission of this image has retired so its queries are ready
+                collectStats(target, static_cast<uint32_t>(targetIndex));
+                if(target.resolutionLevels > 1 && target.latestStats.gpuTimeValid)
+                {
+                    target.resolution.update(target.latestStats.gpuMilliseconds, target.imageResolutionLevel[imageIndex]);
+                }
+            }
+            acquireMilliseconds += milliseconds(std::chrono::steady_clock::now() - acquireStart).count();
+            target.imageResolutionLevel[imageIndex] = target.resolution.level();
+            target.imagesInFlight[imageIndex] = inFlightFences[currentFrame];
+            target.imageSubmittedFrame[imageIndex] = frameNumber;
+
+            frameWaitSemaphores[targetIndex] = target.imageAvailableSemaphores[currentFrame];
+            if(mesh)
+            {
+                placeMeshCopies(target, imageIndex, snapshot);
+                cullMilliseconds += target.latestStats.meshLodMicroseconds / 1000.0;
+            }
+            if(instances.size() > 0)
+            {
+                cullInstances(target, imageIndex, snapshot);
+                cullMilliseconds += target.latestStats.cullMicroseconds / 1000.0;
+            }
+            for(uint32_t chunk = 0; chunk < target.chunks.chunkCount(); ++chunk)
+            {
+                target.chunks.setVisible(chunk, ((snapshot.hiddenChunks >> chunk) & 1) == 0);
+            }
+            if(particles)
+            {
+                target.particleIndirectCommands[imageIndex] = { particles->activeCount, 1, particleFirstVertex(*particles), 0 };
+            }
+            if(target.hudQuads != nullptr && ((snapshot.hiddenChunks >> target.hudChunk) & 1) == 0)
+            {
+                //the image's fence has been waited on, so its slice is free to overwrite
+                auto const hudStart = std::chrono::steady_clock::now();
+                target.hudIndirectCommands[imageIndex].instanceCount = writeHudQuads(target.hudQuads + imageIndex * hudQuadCapacity,
+                    hudQuadCapacity,
+                    target.swapChainExtent,
+                    hudScale,
+                    target.latestStats,
+                    frameTimings);
+                hudMilliseconds += milliseconds(std::chrono::steady_clock::now() - hudStart).count();
+            }
+            frameCommandBuffers[commandBufferCount++] = frameCommandBuffer(target, imageIndex);
+            recordMilliseconds += target.latestStats.recordMicroseconds / 1000.0;
+            frameSwapChains[targetIndex] = target.swapChain;
+            frameImageIndices[targetIndex] = imageIndex;
+        }
+        ++frameNumber;
 
-        VkSemaphore waitSemaphores[] = { imageAvailableSemaphores[currentFrame] };
-        VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
         VkSemaphore signalSemaphores[] = { renderFinishedSemaphores[currentFrame] };
         
         VkSubmitInfo submitInfo{};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-        submitInfo.waitSemaphoreCount = 1;
-        submitInfo.pWaitSemaphores = waitSemaphores;
-        submitInfo.pWaitDstStageMask = waitStages;
-        submitInfo.commandBufferCount = 1;
-        submitInfo.pCommandBuffers = &commandBuffers[imageIndex];
+        submitInfo.waitSemaphoreCount = waitSemaphoreCount;
+        submitInfo.pWaitSemaphores = frameWaitSemaphores.data();
+        submitInfo.pWaitDstStageMask = frameWaitStages.data();
+        submitInfo.commandBufferCount = commandBufferCount;
+        submitInfo.pCommandBuffers = frameCommandBuffers.data();
         submitInfo.signalSemaphoreCount = 1;
         submitInfo.pSignalSemaphores = signalSemaphores;
 
+        auto const submitStart = std::chrono::steady_clock::now();
         vkResetFences(logicalDevice, 1, &inFlightFences[currentFrame]);
         if(VK_FAILED(vkQueueSubmit(graphicsQueue, 1, &submitInfo, inFlightFences[currentFrame])))
         {
@@ -185,21 +491,324 @@ private:
         presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
         presentInfo.waitSemaphoreCount = 1;
         presentInfo.pWaitSemaphores = signalSemaphores;
-        presentInfo.swapchainCount = 1;
-        presentInfo.pSwapchains = &swapChain;
-        presentInfo.pImageIndices = &imageIndex;
+        presentInfo.swapchainCount = static_cast<uint32_t>(frameSwapChains.size());
+        presentInfo.pSwapchains = frameSwapChains.data();
+        presentInfo.pImageIndices = frameImageIndices.data();
+        presentInfo.pResults = framePresentResults.data();
 
         vkQueuePresentKHR(presentationQueue, &presentInfo);
 
+        frameTimings.acquireMilliseconds = acquireMilliseconds;
+        frameTimings.cullMilliseconds = cullMilliseconds;
+        frameTimings.recordMilliseconds = recordMilliseconds;
+        frameTimings.submitMilliseconds = milliseconds(std::chrono::steady_clock::now() - submitStart).count();
+        frameTimings.hudMilliseconds = hudMilliseconds;
         currentFrame = (++currentFrame) % maxFramesInFlight;
     }
+
+    //the frame's fence has just been waited on, so the step that last wrote the half about to be
+    //reused has finished and so have the draws that read it
+    VkSemaphore stepParticleFrame()
+    {
+        uint32_t const half = static_cast<uint32_t>(particles->stepCount % 2);
+        double computeMilliseconds = 0.0;
+        bool const computeValid = particles->stepCount >= 2 && readParticleStepTime(*particles, logicalDevice, half, computeMilliseconds);
+        if(computeValid)
+        {
+            frameTimings.computeValid = true;
+            frameTimings.computeMilliseconds = computeMilliseconds;
+        }
+        if(particleBenchmark.framesPerCount > 0)
+        {
+            advanceParticleBenchmark(computeValid, computeMilliseconds);
+        }
+        return stepParticles(*particles, particleCount, static_cast<uint32_t>(currentFrame));
+    }
+
+    //frame times are wall clock between frames, so under fifo they bottom out at the refresh interval
+    void advanceParticleBenchmark(bool const computeValid, double const computeMilliseconds)
+    {
+        particle_benchmark& benchmark = particleBenchmark;
+        auto const now = std::chrono::steady_clock::now();
+        ++benchmark.frames;
+        if(benchmark.frames == particleBenchmarkWarmupFrames)
+        {
+            //steps from before the count changed have drained by now
+            benchmark.start = now;
+            benchmark.computeMilliseconds = 0.0;
+            benchmark.computeSamples = 0;
+            return;
+        }
+        if(benchmark.frames < particleBenchmarkWarmupFrames)
+        {
+            return;
+        }
+        if(computeValid)
+        {
+            benchmark.computeMilliseconds += computeMilliseconds;
+            ++benchmark.computeSamples;
+        }
+        if(benchmark.frames < particleBenchmarkWarmupFrames + benchmark.framesPerCount)
+        {
+            return;
+        }
+
+        std::cout << "{\"particles\":" << particleCount
+            << ",\"frameMs\":" << std::chrono::duration<double, std::milli>(now - benchmark.start).count() / benchmark.framesPerCount;
+        if(benchmark.computeSamples > 0)
+        {
+            std::cout << ",\"computeMs\":" << benchmark.computeMilliseconds / benchmark.computeSamples;
+        }
+        std::cout << "}\n";
+
+        benchmark.frames = 0;
+        if(particleCount >= particles->capacity)
+        {
+            benchmark.framesPerCount = 0;
+            for(presentation_target const& target : targets)
+            {
+                glfwSetWindowShouldClose(target.window, GLFW_TRUE);
+            }
+            glfwPostEmptyEvent();
+            return;
+        }
+        particleCount = std::min(particleCount * 4, particles->capacity);
+    }
+
+    //with a demand cycle each texture shrinks by halves down to the initial extent and grows back over
+    //that many frames, staggered so some textures are giving levels up while others want them
+    VkExtent2D textureDemandExtent(uint32_t const textureIndex, VkExtent2D const& fullExtent, uint64_t const frameNumber) const
+    {
+        if(textureDemandCycleFrames == 0)
+        {
+            return fullExtent;
+        }
+        uint32_t halvings = 0;
+        while((std::max(fullExtent.width, fullExtent.height) >> halvings) > textureInitialExtent)
+        {
+            ++halvings;
+        }
+        uint64_t const offset = static_cast<uint64_t>(textureIndex) * textureDemandCycleFrames / textures->textureCount();
+        double const phase = static_cast<double>((frameNumber + offset) % textureDemandCycleFrames) / textureDemandCycleFrames;
+        uint32_t const shift = static_cast<uint32_t>(std::lround(halvings * (1.0 - std::abs(2.0 * phase - 1.0))));
+        return { std::max(fullExtent.width >> shift, 1u), std::max(fullExtent.height >> shift, 1u) };
+    }
+
+    //orbiting the origin
+    std::tuple<float4x4, std::array<float, 3>> cameraView(frame_snapshot const& snapshot, VkExtent2D const& extent) const
+    {
+        float const horizontalDistance = snapshot.cameraDistance * std::cos(snapshot.cameraPitch);
+        std::array<float, 3> const eye =
+        {
+            horizontalDistance * std::sin(snapshot.cameraYaw),
+            snapshot.cameraDistance * std::sin(snapshot.cameraPitch),
+            horizontalDistance * std::cos(snapshot.cameraYaw),
+        };
+        float const aspect = static_cast<float>(extent.width) / extent.height;
+        float4x4 const viewProjection = multiply(perspective(cameraFieldOfView, aspect, cameraNearPlane, cameraFarPlane), lookAt(eye, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }));
+        return { viewProjection, eye };
+    }
+
+    //the image's fence has just been waited on, so its slices of the mesh instance and indirect
+    //buffers are free to overwrite
+    void placeMeshCopies(presentation_target& target, uint32_t const imageIndex, frame_snapshot const& snapshot)
+    {
+        auto const[viewProjection, eye] = cameraView(snapshot, target.swapChainExtent);
+        //error is judged in the pixels actually rendered, so a lower resolution level coarsens the meshes too
+        float const renderScale = target.resolutionLevels > 1 ? resolutionScale(target.imageResolutionLevel[imageIndex]) : 1.0f;
+        float const unitPixels = target.swapChainExtent.height * renderScale / (2.0f * std::tan(cameraFieldOfView / 2.0f));
+
+        auto const start = std::chrono::steady_clock::now();
+        mesh_file_header const& header = mesh->header;
+        uint32_t const imageCount = static_cast<uint32_t>(target.swapChainImages.size());
+        mesh_field_counts const counts = writeMeshFieldInstances(meshField,
+            header,
+            mesh->residentIndexCount,
+            viewProjection,
+            eye,
+            unitPixels,
+            meshPixelError,
+            target.meshInstances + imageIndex * header.lodCount * target.meshCopyCount);
+        for(uint32_t lod = 0; lod < header.lodCount; ++lod)
+        {
+            target.indirectCommands[lod * imageCount + imageIndex] = { header.lods[lod].indexCount, counts.copies[lod], header.lods[lod].firstIndex, 0, 0 };
+        }
+
+        frame_stats& stats = target.latestStats;
+        stats.meshLodValid = true;
+        stats.meshCopiesTotal = meshField.size();
+        stats.meshCopiesVisible = counts.visible;
+        stats.meshTriangles = counts.triangles;
+        stats.meshFullDetailTriangles = counts.fullDetailTriangles;
+        stats.meshLodMicroseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    //the image's fence has just been waited on, so its slice of the instance buffer is free to overwrite
+    void cullInstances(presentation_target& target, uint32_t const imageIndex, frame_snapshot const& snapshot)
+    {
+        float4x4 const viewProjection = std::get<0>(cameraView(snapshot, target.swapChainExtent));
+
+        auto const start = std::chrono::steady_clock::now();
+        uint32_t const visible = cullKernel.function(instances, extractFrustumPlanes(viewProjection), viewProjection, target.instanceData + imageIndex * target.instanceCapacity);
+        target.instanceIndirectCommands[imageIndex].instanceCount = visible;
+
+        frame_stats& stats = target.latestStats;
+        stats.cullingValid = true;
+        stats.cullKernel = cullKernel.name;
+        stats.instancesTotal = instances.size();
+        stats.instancesVisible = visible;
+        stats.cullMicroseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void collectStats(presentation_target& target, uint32_t const targetIndex)
+    {
+        frame_stats& stats = target.latestStats;
+        stats.targetIndex = targetIndex;
+        stats.frameNumber = target.imageSubmittedFrame[target.acquiredImage];
+        readStatsQueries(logicalDevice, target.statsPools, target.acquiredImage, stats);
+        stats.resolutionScale = target.resolutionLevels > 1 ? resolutionScale(target.imageResolutionLevel[target.acquiredImage]) : 1.0f;
+        stats.hostAllocations = hostAllocator.allocationCount();
+        stats.hostLiveBytes = hostAllocator.liveBytes();
+        stats.steadyStateHostAllocations = stats.frameNumber > hostAllocationWarmupFrames ? stats.hostAllocations - warmupHostAllocations : 0;
+        //the budget query goes to the driver, so not every frame. the first collected frame always asks.
+        if(stats.heapCount == 0 || stats.frameNumber % memoryBudgetInterval == 0)
+        {
+            queryMemoryBudget(physicalDevice, memoryBudgetEnabled, stats);
+        }
+        if(stats.frameNumber % statsLogInterval == 0)
+        {
+            writeFrameStatsJson(std::cout, stats);
+        }
+    }
 };
 
+//--make-mesh <file> [cells]: writes a grid mesh, with its levels of detail, for --mesh <file> to stream in
+void makeGridMeshFile(std::string const& fileName, uint32_t const cellsPerSide)
+{
+    auto const[vertices, fullDetailIndices] = createGridMesh(cellsPerSide);
+    auto const[indices, lods] = buildMeshLods(vertices, fullDetailIndices);
+    writeMeshFile(fileName, vertices, indices, lods);
+    std::cout << "{\"file\":\"" << fileName << "\",\"vertices\":" << vertices.size() << ",\"indices\":" << indices.size() << ",\"lods\":[";
+    for(mesh_lod const& lod : lods)
+    {
+        std::cout << (&lod == &lods.front() ? "" : ",") << "{\"triangles\":" << lod.indexCount / 3 << ",\"error\":" << lod.error << '}';
+    }
+    std::cout << "]}\n";
+}
+
+//--make-texture <file> [size] [stored levels]: writes a checkerboard for --texture <file>
+void makeCheckerTextureFile(std::string const& fileName, uint32_t const size, uint32_t const storedLevelCount)
+{
+    writeTextureFile(fileName, VK_FORMAT_R8G8B8A8_UNORM, size, size, createCheckerTexture(size, storedLevelCount));
+    std::cout << "{\"file\":\"" << fileName << "\",\"size\":" << size << ",\"storedLevels\":" << std::min(storedLevelCount, fullMipLevelCount(size, size)) << "}\n";
+}
+
+//--farm [contexts] [jobs]: render jobs offscreen across worker threads instead of opening windows
+void runRenderFarm(uint32_t const contextCount, uint32_t const jobCount)
+{
+    render_farm farm(contextCount, { windowWidth, windowHeight });
+
+    vector<render_job> jobs(jobCount);
+    for(render_job& job : jobs)
+    {
+        job.id = static_cast<uint32_t>(&job - &jobs[0]);
+        float const shade = static_cast<float>(job.id) / jobCount;
+        job.clearColor = { { shade, 0.0f, 1.0f - shade, 1.0f } };
+    }
+
+    auto const start = std::chrono::steady_clock::now();
+    vector<render_job_result> const results = farm.run(jobs);
+    double const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double slowestJob = 0.0;
+    for(render_job_result const& result : results)
+    {
+        slowestJob = std::max(slowestJob, result.milliseconds);
+    }
+    std::cout << "{\"contexts\":" << farm.contextCount()
+        << ",\"queues\":" << farm.queueCount()
+        << ",\"jobs\":" << jobCount
+        << ",\"seconds\":" << seconds
+        << ",\"jobsPerSecond\":" << jobCount / seconds
+        << ",\"slowestJobMs\":" << slowestJob << "}\n";
+}
+
 //TODO: make shader compilation a build step.
-int main() {
+int main(int argc, char** argv) {
 	try 
     {
-        HelloTriangleApplication app;
+        if(argc > 1 && std::string(argv[1]) == "--farm")
+        {
+            uint32_t const contextCount = argc > 2 ? std::stoul(argv[2]) : std::max(std::thread::hardware_concurrency(), 1u);
+            uint32_t const jobCount = argc > 3 ? std::stoul(argv[3]) : contextCount * 16;
+            runRenderFarm(contextCount, jobCount);
+            return EXIT_SUCCESS;
+        }
+        if(argc > 2 && std::string(argv[1]) == "--make-mesh")
+        {
+            makeGridMeshFile(argv[2], argc > 3 ? std::stoul(argv[3]) : 1024);
+            return EXIT_SUCCESS;
+        }
+        if(argc > 2 && std::string(argv[1]) == "--make-texture")
+        {
+            makeCheckerTextureFile(argv[2], argc > 3 ? std::stoul(argv[3]) : 2048, argc > 4 ? std::stoul(argv[4]) : textureMaxLevels);
+            return EXIT_SUCCESS;
+        }
+
+        application_options options;
+        for(int i = 1; i + 1 < argc; i += 2)
+        {
+            std::string const option = argv[i];
+            if(option == "--mesh")
+            {
+                options.meshFileName = argv[i + 1];
+            }
+            else if(option == "--mesh-copies")
+            {
+                options.meshCopiesPerSide = std::max(static_cast<uint32_t>(std::stoul(argv[i + 1])), 1u);
+            }
+            else if(option == "--mesh-lod-error")
+            {
+                options.meshPixelError = std::stof(argv[i + 1]);
+            }
+            else if(option == "--texture")
+            {
+                options.textureFileNames.push_back(argv[i + 1]);
+            }
+            else if(option == "--texture-budget-mb")
+            {
+                options.textureBudget = std::stoull(argv[i + 1]) * 1024 * 1024;
+            }
+            else if(option == "--texture-demand-cycle")
+            {
+                options.textureDemandCycleFrames = std::stoul(argv[i + 1]);
+            }
+            else if(option == "--dynamic-resolution")
+            {
+                options.targetFrameMilliseconds = std::stod(argv[i + 1]);
+            }
+            else if(option == "--instances")
+            {
+                options.instanceCount = std::stoul(argv[i + 1]);
+            }
+            else if(option == "--particles")
+            {
+                options.particleCount = std::stoul(argv[i + 1]);
+            }
+            else if(option == "--particle-benchmark")
+            {
+                options.particleBenchmarkFrames = std::stoul(argv[i + 1]);
+            }
+            else if(option == "--hud")
+            {
+                options.hudScale = std::stoul(argv[i + 1]);
+            }
+            else
+            {
+                throw std::runtime_error("Unknown option " + option);
+            }
+        }
+        HelloTriangleApplication app(options);
     }
 	catch(const std::exception& e) {
 		std::cerr << e.what() << std::endl;
@@ -0,0 +1,141 @@
+#include "mapped_file.h"
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    uint64_t alignUp(uint64_t const value, uint64_t const alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    uint64_t pageSize()
+    {
+#ifdef _WIN32
+        SYSTEM_INFO systemInfo;
+        GetSystemInfo(&systemInfo);
+        return systemInfo.dwPageSize;
+#else
+        return static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#endif
+    }
+}
+
+mapped_file::~mapped_file()
+{
+    close();
+}
+
+void mapped_file::open(std::string const& fileName)
+{
+    close();
+#ifdef _WIN32
+    fileHandle = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if(fileHandle == INVALID_HANDLE_VALUE)
+    {
+        fileHandle = nullptr;
+        throw std::runtime_error("Failed to open " + fileName);
+    }
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(fileHandle, &fileSize);
+    byteCount = static_cast<uint64_t>(fileSize.QuadPart);
+    if(byteCount == 0)
+    {
+        close();
+        throw std::runtime_error(fileName + " is empty.");
+    }
+    mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if(!mappingHandle)
+    {
+        close();
+        throw std::runtime_error("Failed to map " + fileName);
+    }
+    view = static_cast<uint8_t const*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+#else
+    fileDescriptor = ::open(fileName.c_str(), O_RDONLY);
+    if(fileDescriptor < 0)
+    {
+        throw std::runtime_error("Failed to open " + fileName);
+    }
+    struct stat fileStatus;
+    fstat(fileDescriptor, &fileStatus);
+    byteCount = static_cast<uint64_t>(fileStatus.st_size);
+    if(byteCount == 0)
+    {
+        close();
+        throw std::runtime_error(fileName + " is empty.");
+    }
+    void* const mapping = mmap(nullptr, byteCount, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    if(mapping != MAP_FAILED)
+    {
+        view = static_cast<uint8_t const*>(mapping);
+        madvise(mapping, byteCount, MADV_SEQUENTIAL);
+    }
+#endif
+    if(!view)
+    {
+        close();
+        throw std::runtime_error("Failed to map " + fileName);
+    }
+}
+
+void mapped_file::close()
+{
+#ifdef _WIN32
+    if(view)
+    {
+        UnmapViewOfFile(view);
+    }
+    if(mappingHandle)
+    {
+        CloseHandle(mappingHandle);
+    }
+    if(fileHandle)
+    {
+        CloseHandle(fileHandle);
+    }
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+#else
+    if(view)
+    {
+        munmap(const_cast<uint8_t*>(view), byteCount);
+    }
+    if(fileDescriptor >= 0)
+    {
+        ::close(fileDescriptor);
+    }
+    fileDescriptor = -1;
+#endif
+    view = nullptr;
+    byteCount = 0;
+}
+
+void mapped_file::release(uint64_t const offset, uint64_t const size) const
+{
+    //only whole pages inside the range, a partial page at either end may still be wanted
+    uint64_t const page = pageSize();
+    uint64_t const first = alignUp(offset, page);
+    uint64_t const last = std::min(offset + size, byteCount) / page * page;
+    if(!view || last <= first)
+    {
+        return;
+    }
+#ifdef _WIN32
+    //unlocking pages that were never locked takes them out of the working set
+    VirtualUnlock(const_cast<uint8_t*>(view + first), last - first);
+#else
+    madvise(const_cast<uint8_t*>(view + first), last - first, MADV_DONTNEED);
+#endif
+}
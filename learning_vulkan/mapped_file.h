@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+//read only view of a whole file. pages come in on first touch and can be handed back with
+//release once copied out, so streaming from a file never holds more than a chunk or two resident.
+class mapped_file
+{
+public:
+    mapped_file() = default;
+    ~mapped_file();
+
+    mapped_file(mapped_file const&) = delete;
+    mapped_file& operator=(mapped_file const&) = delete;
+
+    void open(std::string const& fileName);
+    void close();
+
+    uint8_t const* data() const { return view; }
+    uint64_t size() const { return byteCount; }
+
+    //a hint, the range stays readable and faults back in if touched again
+    void release(uint64_t const offset, uint64_t const size) const;
+
+private:
+    uint8_t const* view = nullptr;
+    uint64_t byteCount = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#else
+    int fileDescriptor = -1;
+#endif
+};
@@ -0,0 +1,139 @@
+#include "mesh_file.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable<mesh_file_header>::value, "the header is read straight out of the mapping");
+static_assert(sizeof(mesh_vertex) == 24, "mesh_vertex must match the vertex input description");
+
+namespace
+{
+    uint64_t alignUp(uint64_t const value, uint64_t const alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+}
+
+mesh_file_header const& validateMeshFile(mapped_file const& file)
+{
+    if(file.size() < sizeof(mesh_file_header))
+    {
+        throw std::runtime_error("Mesh file is too small to hold a header.");
+    }
+    mesh_file_header const& header = *reinterpret_cast<mesh_file_header const*>(file.data());
+    if(header.magic != meshFileMagic || header.version != meshFileVersion)
+    {
+        throw std::runtime_error("Not a mesh file, or one written by a different version.");
+    }
+    if(header.vertexStride != sizeof(mesh_vertex) || header.indexSize != sizeof(uint32_t))
+    {
+        throw std::runtime_error("Mesh file vertex or index layout does not match this build.");
+    }
+    if(header.vertexOffset % meshFileAlignment || header.indexOffset % meshFileAlignment)
+    {
+        throw std::runtime_error("Mesh file arrays are not aligned.");
+    }
+    //the counts are 32 bit and the strides fixed, so only adding the offsets could wrap
+    uint64_t const vertexBytes = static_cast<uint64_t>(header.vertexCount) * header.vertexStride;
+    uint64_t const indexBytes = static_cast<uint64_t>(header.indexCount) * header.indexSize;
+    if(header.vertexOffset > file.size() || vertexBytes > file.size() - header.vertexOffset
+        || header.indexOffset > file.size() || indexBytes > file.size() - header.indexOffset
+        || header.indexCount % 3)
+    {
+        throw std::runtime_error("Mesh file is truncated or corrupt.");
+    }
+    if(header.lodCount == 0 || header.lodCount > meshMaxLods)
+    {
+        throw std::runtime_error("Mesh file has no levels of detail, or more than this build can draw.");
+    }
+    for(uint32_t lod = 0; lod < header.lodCount; ++lod)
+    {
+        mesh_lod const& range = header.lods[lod];
+        if(static_cast<uint64_t>(range.firstIndex) + range.indexCount > header.indexCount || range.indexCount % 3)
+        {
+            throw std::runtime_error("Mesh file level of detail is outside of its indices.");
+        }
+    }
+    return header;
+}
+
+void writeMeshFile(std::string const& fileName, std::vector<mesh_vertex> const& vertices, std::vector<uint32_t> const& indices, std::vector<mesh_lod> const& lods)
+{
+    if(lods.empty() || lods.size() > meshMaxLods)
+    {
+        throw std::runtime_error("A mesh file needs between 1 and " + std::to_string(meshMaxLods) + " levels of detail.");
+    }
+    mesh_file_header header{};
+    header.magic = meshFileMagic;
+    header.version = meshFileVersion;
+    header.vertexStride = sizeof(mesh_vertex);
+    header.indexSize = sizeof(uint32_t);
+    header.vertexCount = static_cast<uint32_t>(vertices.size());
+    header.indexCount = static_cast<uint32_t>(indices.size());
+    header.vertexOffset = alignUp(sizeof(mesh_file_header), meshFileAlignment);
+    header.indexOffset = alignUp(header.vertexOffset + vertices.size() * sizeof(mesh_vertex), meshFileAlignment);
+    header.lodCount = static_cast<uint32_t>(lods.size());
+    std::copy(begin(lods), end(lods), header.lods);
+    for(uint32_t axis = 0; axis < 3 && !vertices.empty(); ++axis)
+    {
+        header.boundsMin[axis] = header.boundsMax[axis] = vertices.front().position[axis];
+    }
+    for(mesh_vertex const& vertex : vertices)
+    {
+        for(uint32_t axis = 0; axis < 3; ++axis)
+        {
+            header.boundsMin[axis] = std::min(header.boundsMin[axis], vertex.position[axis]);
+            header.boundsMax[axis] = std::max(header.boundsMax[axis], vertex.position[axis]);
+        }
+    }
+
+    std::ofstream file(fileName, std::ios::binary);
+    if(!file.is_open())
+    {
+        throw std::runtime_error("Failed to open " + fileName);
+    }
+    char const padding[meshFileAlignment] = {};
+    file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    file.write(padding, header.vertexOffset - sizeof(header));
+    file.write(reinterpret_cast<char const*>(vertices.data()), vertices.size() * sizeof(mesh_vertex));
+    file.write(padding, header.indexOffset - header.vertexOffset - vertices.size() * sizeof(mesh_vertex));
+    file.write(reinterpret_cast<char const*>(indices.data()), indices.size() * sizeof(uint32_t));
+    if(!file)
+    {
+        throw std::runtime_error("Failed to write " + fileName);
+    }
+}
+
+std::tuple<std::vector<mesh_vertex>, std::vector<uint32_t>> createGridMesh(uint32_t const cellsPerSide)
+{
+    uint32_t const verticesPerSide = cellsPerSide + 1;
+    std::vector<mesh_vertex> vertices;
+    vertices.reserve(static_cast<size_t>(verticesPerSide) * verticesPerSide);
+    for(uint32_t row = 0; row < verticesPerSide; ++row)
+    {
+        for(uint32_t column = 0; column < verticesPerSide; ++column)
+        {
+            float const u = static_cast<float>(column) / cellsPerSide;
+            float const v = static_cast<float>(row) / cellsPerSide;
+            //enough relief that simplifying it has an error to measure
+            float const height = 0.08f * std::sin(u * 18.0f) * std::cos(v * 14.0f);
+            vertices.push_back({ { u * 1.8f - 0.9f, v * 1.8f - 0.9f, height }, { u, v, 1.0f - u } });
+        }
+    }
+
+    //clockwise on screen to match the pipeline's front face
+    std::vector<uint32_t> indices;
+    indices.reserve(static_cast<size_t>(cellsPerSide) * cellsPerSide * 6);
+    for(uint32_t row = 0; row < cellsPerSide; ++row)
+    {
+        for(uint32_t column = 0; column < cellsPerSide; ++column)
+        {
+            uint32_t const topLeft = row * verticesPerSide + column;
+            uint32_t const bottomLeft = topLeft + verticesPerSide;
+            indices.insert(indices.end(), { topLeft, topLeft + 1, bottomLeft + 1, topLeft, bottomLeft + 1, bottomLeft });
+        }
+    }
+    return { vertices, indices };
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "mapped_file.h"
+
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <vector>
+
+//.lvmesh: a fixed header followed by the vertex and index arrays exactly as the gpu reads them,
+//each starting on a meshFileAlignment boundary so they can be copied out of the mapping untouched.
+//every level of detail indexes the one vertex array, their index ranges sit back to back.
+constexpr uint32_t meshFileMagic = 0x48534d4c;//"LMSH"
+constexpr uint32_t meshFileVersion = 2;
+constexpr uint64_t meshFileAlignment = 256;
+constexpr uint32_t meshMaxLods = 8;
+
+struct mesh_vertex
+{
+    float position[3];
+    float color[3];
+};
+
+//a range of the index array drawing the whole mesh at one level of detail
+struct mesh_lod
+{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    float error;//furthest any vertex moved from the full detail mesh, in the mesh's own units
+};
+
+struct mesh_file_header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vertexStride;
+    uint32_t indexSize;//always 4, uint32 indices
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint64_t vertexOffset;//from the start of the file
+    uint64_t indexOffset;
+    float boundsMin[3];
+    float boundsMax[3];
+    uint32_t lodCount;
+    mesh_lod lods[meshMaxLods];//finest first, error never decreases
+};
+
+//throws if the mapping is not a complete mesh file this build understands. only the header is read,
+//the indices themselves are checked against vertexCount as they stream in.
+mesh_file_header const& validateMeshFile(mapped_file const& file);
+
+//indices holds every level's range, lods says where they are
+void writeMeshFile(std::string const& fileName, std::vector<mesh_vertex> const& vertices, std::vector<uint32_t> const& indices, std::vector<mesh_lod> const& lods);
+
+//a rippled square of cellsPerSide^2 quads for exercising the streaming and level of detail paths
+//with arbitrarily large meshes
+std::tuple<std::vector<mesh_vertex>, std::vector<uint32_t>> createGridMesh(uint32_t const cellsPerSide);
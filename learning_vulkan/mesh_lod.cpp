@@ -0,0 +1,244 @@
+#include "mesh_lod.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace
+{
+    using triangle = std::array<uint32_t, 3>;
+
+    float distanceBetween(float const* left, float const* right)
+    {
+        float const x = left[0] - right[0];
+        float const y = left[1] - right[1];
+        float const z = left[2] - right[2];
+        return std::sqrt(x * x + y * y + z * z);
+    }
+
+    //which vertex each vertex collapses onto when they're clustered into cubes of cellSize, and the
+    //furthest any of them moved
+    std::tuple<std::vector<uint32_t>, float> clusterVertices(std::vector<mesh_vertex> const& vertices, float const boundsMin[3], float const cellSize)
+    {
+        std::unordered_map<uint64_t, uint32_t> clusterOfCell;
+        std::vector<uint32_t> clusterOfVertex(vertices.size());
+        std::vector<std::array<float, 4>> sums;//position total and vertex count
+        for(uint32_t vertex = 0; vertex < vertices.size(); ++vertex)
+        {
+            uint64_t cell = 0;
+            for(uint32_t axis = 0; axis < 3; ++axis)
+            {
+                uint64_t const coordinate = static_cast<uint64_t>((vertices[vertex].position[axis] - boundsMin[axis]) / cellSize);
+                cell = (cell << 21) | (coordinate & 0x1fffff);
+            }
+            auto const inserted = clusterOfCell.emplace(cell, static_cast<uint32_t>(sums.size()));
+            if(inserted.second)
+            {
+                sums.push_back({});
+            }
+            uint32_t const cluster = inserted.first->second;
+            clusterOfVertex[vertex] = cluster;
+            std::array<float, 4>& sum = sums[cluster];
+            for(uint32_t axis = 0; axis < 3; ++axis)
+            {
+                sum[axis] += vertices[vertex].position[axis];
+            }
+            sum[3] += 1.0f;
+        }
+
+        //the vertex nearest each centroid stands in for its cluster, so no new vertices are needed
+        std::vector<uint32_t> representatives(sums.size(), UINT32_MAX);
+        std::vector<float> nearest(sums.size(), 0.0f);
+        for(uint32_t vertex = 0; vertex < vertices.size(); ++vertex)
+        {
+            uint32_t const cluster = clusterOfVertex[vertex];
+            std::array<float, 4> const& sum = sums[cluster];
+            float const centroid[3] = { sum[0] / sum[3], sum[1] / sum[3], sum[2] / sum[3] };
+            float const distance = distanceBetween(vertices[vertex].position, centroid);
+            if(representatives[cluster] == UINT32_MAX || distance < nearest[cluster])
+            {
+                representatives[cluster] = vertex;
+                nearest[cluster] = distance;
+            }
+        }
+
+        std::vector<uint32_t> remap(vertices.size());
+        float error = 0.0f;
+        for(uint32_t vertex = 0; vertex < vertices.size(); ++vertex)
+        {
+            remap[vertex] = representatives[clusterOfVertex[vertex]];
+            error = std::max(error, distanceBetween(vertices[vertex].position, vertices[remap[vertex]].position));
+        }
+        return { remap, error };
+    }
+
+    //drops the triangles that collapsed to a line or a point and any left duplicated, keeping the winding
+    std::vector<uint32_t> collapseTriangles(std::vector<uint32_t> const& indices, std::vector<uint32_t> const& remap)
+    {
+        std::vector<triangle> triangles;
+        triangles.reserve(indices.size() / 3);
+        for(size_t i = 0; i < indices.size(); i += 3)
+        {
+            triangle corners = { remap[indices[i]], remap[indices[i + 1]], remap[indices[i + 2]] };
+            if(corners[0] == corners[1] || corners[1] == corners[2] || corners[2] == corners[0])
+            {
+                continue;
+            }
+            std::rotate(begin(corners), std::min_element(begin(corners), end(corners)), end(corners));
+            triangles.push_back(corners);
+        }
+        //sorted on the lowest index, which also keeps neighbouring triangles together for the vertex cache
+        std::sort(begin(triangles), end(triangles));
+        triangles.erase(std::unique(begin(triangles), end(triangles)), end(triangles));
+
+        std::vector<uint32_t> reply;
+        reply.reserve(triangles.size() * 3);
+        for(triangle const& corners : triangles)
+        {
+            reply.insert(end(reply), begin(corners), end(corners));
+        }
+        return reply;
+    }
+}
+
+std::tuple<std::vector<uint32_t>, std::vector<mesh_lod>> buildMeshLods(std::vector<mesh_vertex> const& vertices, std::vector<uint32_t> const& indices)
+{
+    if(indices.size() % 3)
+    {
+        throw std::runtime_error("Mesh indices are not whole triangles.");
+    }
+    float boundsMin[3] = {};
+    for(uint32_t axis = 0; axis < 3 && !vertices.empty(); ++axis)
+    {
+        boundsMin[axis] = vertices.front().position[axis];
+    }
+    for(mesh_vertex const& vertex : vertices)
+    {
+        for(uint32_t axis = 0; axis < 3; ++axis)
+        {
+            boundsMin[axis] = std::min(boundsMin[axis], vertex.position[axis]);
+        }
+    }
+    double edgeTotal = 0.0;
+    for(size_t i = 0; i < indices.size(); ++i)
+    {
+        size_t const next = i % 3 == 2 ? i - 2 : i + 1;
+        edgeTotal += distanceBetween(vertices[indices[i]].position, vertices[indices[next]].position);
+    }
+    float const meanEdge = indices.empty() ? 0.0f : static_cast<float>(edgeTotal / indices.size());
+
+    //each cell is twice the size of the last, so each level should have about a quarter of the triangles
+    std::vector<std::vector<uint32_t>> levels = { indices };
+    std::vector<float> errors = { 0.0f };
+    float cellSize = meanEdge;
+    while(levels.size() < meshMaxLods && levels.back().size() / 3 > meshLodMinimumTriangles && cellSize > 0.0f)
+    {
+        cellSize *= 2.0f;
+        auto const[remap, error] = clusterVertices(vertices, boundsMin, cellSize);
+        std::vector<uint32_t> simplified = collapseTriangles(indices, remap);
+        if(simplified.empty())
+        {
+            break;
+        }
+        if(simplified.size() * 4 > levels.back().size() * 3)
+        {
+            continue;
+        }
+        levels.push_back(std::move(simplified));
+        errors.push_back(std::max(error, errors.back()));
+    }
+
+    std::vector<uint32_t> reply;
+    std::vector<mesh_lod> lods(levels.size());
+    for(size_t level = levels.size(); level-- > 0;)
+    {
+        lods[level] = { static_cast<uint32_t>(reply.size()), static_cast<uint32_t>(levels[level].size()), errors[level] };
+        reply.insert(end(reply), begin(levels[level]), end(levels[level]));
+    }
+    return { reply, lods };
+}
+
+uint32_t selectMeshLod(mesh_file_header const& header, float const pixelsPerUnit, float const maxPixelError, uint32_t const residentIndexCount)
+{
+    uint32_t reply = 0;
+    while(reply + 1 < header.lodCount && header.lods[reply + 1].error * pixelsPerUnit <= maxPixelError)
+    {
+        ++reply;
+    }
+    //coarser levels come first in the index buffer, so they are resident sooner
+    while(reply < header.lodCount && header.lods[reply].firstIndex + header.lods[reply].indexCount > residentIndexCount)
+    {
+        ++reply;
+    }
+    return reply;
+}
+
+mesh_field createMeshField(mesh_file_header const& header, uint32_t const copiesPerSide)
+{
+    float const center[3] =
+    {
+        (header.boundsMin[0] + header.boundsMax[0]) / 2.0f,
+        (header.boundsMin[1] + header.boundsMax[1]) / 2.0f,
+        (header.boundsMin[2] + header.boundsMax[2]) / 2.0f,
+    };
+    float const extent = std::max({ header.boundsMax[0] - header.boundsMin[0], header.boundsMax[1] - header.boundsMin[1], header.boundsMax[2] - header.boundsMin[2] });
+
+    mesh_field reply;
+    reply.scale = extent > 0.0f ? meshFieldCopySize / extent : 1.0f;
+    float const radius = reply.scale * distanceBetween(header.boundsMin, header.boundsMax) / 2.0f;
+    float const s = reply.scale;
+    for(uint32_t row = 0; row < copiesPerSide; ++row)
+    {
+        for(uint32_t column = 0; column < copiesPerSide; ++column)
+        {
+            float const x = (column - (copiesPerSide - 1) / 2.0f) * meshFieldSpacing;
+            float const z = (row - (copiesPerSide - 1) / 2.0f) * meshFieldSpacing;
+
+            //the mesh's z becomes height, its y runs along -z
+            float4x4 model;
+            model.m = { s, 0.0f, 0.0f, 0.0f,
+                0.0f, 0.0f, -s, 0.0f,
+                0.0f, s, 0.0f, 0.0f,
+                x - s * center[0], -s * center[2], z + s * center[1], 1.0f };
+            reply.models.push_back(model);
+            reply.spheres.push_back({ x, 0.0f, z, radius });
+        }
+    }
+    return reply;
+}
+
+mesh_field_counts writeMeshFieldInstances(mesh_field const& field,
+    mesh_file_header const& header,
+    uint32_t const residentIndexCount,
+    float4x4 const& viewProjection,
+    std::array<float, 3> const& eye,
+    float const unitPixels,
+    float const maxPixelError,
+    float4x4* out)
+{
+    mesh_field_counts reply;
+    frustum_planes const frustum = extractFrustumPlanes(viewProjection);
+    for(uint32_t copy = 0; copy < field.size(); ++copy)
+    {
+        std::array<float, 4> const& sphere = field.spheres[copy];
+        if(!sphereVisible(frustum, sphere[0], sphere[1], sphere[2], sphere[3]))
+        {
+            continue;
+        }
+        //from the nearest point of the bounds, so no part of the copy is off by more than the limit.
+        //inside the bounds that's no distance at all and the full detail is drawn.
+        float const distance = std::max(distanceBetween(sphere.data(), eye.data()) - sphere[3], 0.0f);
+        float const pixelsPerUnit = distance > 0.0f ? unitPixels * field.scale / distance : std::numeric_limits<float>::max();
+        uint32_t const lod = selectMeshLod(header, pixelsPerUnit, maxPixelError, residentIndexCount);
+        if(lod == header.lodCount)
+        {
+            continue;
+        }
+        out[lod * field.size() + reply.copies[lod]++] = multiply(viewProjection, field.models[copy]);
+        ++reply.visible;
+        reply.triangles += header.lods[lod].indexCount / 3;
+        reply.fullDetailTriangles += header.lods[0].indexCount / 3;
+    }
+    return reply;
+}
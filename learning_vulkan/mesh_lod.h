@@ -0,0 +1,57 @@
+#pragma once
+
+#include "instance_culling.h"
+#include "mesh_file.h"
+
+#include <array>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+constexpr uint32_t meshLodMinimumTriangles = 64;//the chain stops once a level is this small
+constexpr float meshLodDefaultPixelError = 1.0f;//how far off a level may look before a finer one is drawn
+constexpr float meshFieldCopySize = 16.0f;//world units across the widest side of a copy
+constexpr float meshFieldSpacing = 20.0f;//between neighbouring copies' centres
+
+//simplifies by clustering vertices on successively coarser grids, every cluster collapsing onto the
+//one of its own vertices nearest its centroid, so all the levels share the original vertex array.
+//levels that don't lose at least a quarter of the triangles are skipped. the indices come back with
+//the coarsest level first, so while a mesh streams in the distant levels are drawable soonest.
+std::tuple<std::vector<uint32_t>, std::vector<mesh_lod>> buildMeshLods(std::vector<mesh_vertex> const& vertices, std::vector<uint32_t> const& indices);
+
+//the coarsest level whose error, at pixelsPerUnit, is within maxPixelError, or failing that the
+//next coarser one that is resident. lodCount when no level is resident yet.
+uint32_t selectMeshLod(mesh_file_header const& header, float const pixelsPerUnit, float const maxPixelError, uint32_t const residentIndexCount);
+
+//copies of one mesh on a square grid across the xz plane, each lying flat and centred on its cell
+struct mesh_field
+{
+    std::vector<float4x4> models;
+    std::vector<std::array<float, 4>> spheres;//world space centre and radius
+    float scale = 1.0f;//world units per mesh unit
+
+    uint32_t size() const { return static_cast<uint32_t>(models.size()); }
+};
+
+mesh_field createMeshField(mesh_file_header const& header, uint32_t const copiesPerSide);
+
+//what one view of the field came to
+struct mesh_field_counts
+{
+    std::array<uint32_t, meshMaxLods> copies{};//drawn at each level
+    uint32_t visible = 0;
+    uint64_t triangles = 0;
+    uint64_t fullDetailTriangles = 0;//had every visible copy been drawn at level 0
+};
+
+//frustum culls the copies and picks each survivor's level from its projected error, writing
+//viewProjection * model into that level's run of out. out holds field.size() transforms per level.
+//unitPixels is how many pixels a world unit covers one unit in front of the camera.
+mesh_field_counts writeMeshFieldInstances(mesh_field const& field,
+    mesh_file_header const& header,
+    uint32_t const residentIndexCount,
+    float4x4 const& viewProjection,
+    std::array<float, 3> const& eye,
+    float const unitPixels,
+    float const maxPixelError,
+    float4x4* out);
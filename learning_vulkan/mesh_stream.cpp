@@ -0,0 +1,196 @@
+#include "mesh_stream.h"
+#include "instance_culling.h"
+#include <cstddef>
+#include <cstring>
+
+void openStreamedMesh(streamed_mesh& mesh,
+    std::string const& fileName,
+    VkPhysicalDevice const& physicalDevice,
+    VkDevice const& logicalDevice,
+    queue_family_index_t const graphicsFamily,
+    host_allocator& hostAllocator)
+{
+    //no copy of the file is ever made on the heap, the mapping is the only cpu side storage
+    mesh.file.open(fileName);
+    mesh.header = validateMeshFile(mesh.file);
+
+    VkDeviceSize const vertexBytes = static_cast<VkDeviceSize>(mesh.header.vertexCount) * mesh.header.vertexStride;
+    VkDeviceSize const indexBytes = static_cast<VkDeviceSize>(mesh.header.indexCount) * mesh.header.indexSize;
+    std::tie(mesh.vertexBuffer, mesh.vertexMemory) = createBuffer(physicalDevice,
+        logicalDevice,
+        std::max<VkDeviceSize>(vertexBytes, 1),
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        hostAllocator);
+    std::tie(mesh.indexBuffer, mesh.indexMemory) = createBuffer(physicalDevice,
+        logicalDevice,
+        std::max<VkDeviceSize>(indexBytes, 1),
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        hostAllocator);
+
+    VkDeviceSize const stagingSize = meshStreamChunkSize * maxFramesInFlight;
+    std::tie(mesh.stagingBuffer, mesh.stagingMemory) = createBuffer(physicalDevice,
+        logicalDevice,
+        stagingSize,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        hostAllocator);
+    void* stagingMapping;
+    vkMapMemory(logicalDevice, mesh.stagingMemory, 0, stagingSize, 0, &stagingMapping);
+    mesh.stagingMapping = static_cast<uint8_t*>(stagingMapping);
+
+    //a pool per frame so a whole frame's upload can be reset at once
+    mesh.uploadPools.resize(maxFramesInFlight);
+    mesh.uploadCommandBuffers.resize(maxFramesInFlight);
+    for(VkCommandPool& pool : mesh.uploadPools)
+    {
+        size_t const frameIndex = &pool - &mesh.uploadPools[0];
+        pool = createCommandPool(logicalDevice, graphicsFamily, hostAllocator);
+
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = pool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = 1;
+        if(VK_FAILED(vkAllocateCommandBuffers(logicalDevice, &allocInfo, &mesh.uploadCommandBuffers[frameIndex])))
+        {
+            throw std::runtime_error("Failed to allocate mesh upload command buffers.");
+        }
+    }
+}
+
+void destroyStreamedMesh(streamed_mesh& mesh, VkDevice const& logicalDevice, host_allocator& hostAllocator)
+{
+    for(VkCommandPool const& pool : mesh.uploadPools)
+    {
+        vkDestroyCommandPool(logicalDevice, pool, hostAllocator.callbacks(VK_OBJECT_TYPE_COMMAND_POOL));
+    }
+    vkUnmapMemory(logicalDevice, mesh.stagingMemory);
+    vkDestroyBuffer(logicalDevice, mesh.stagingBuffer, hostAllocator.callbacks(VK_OBJECT_TYPE_BUFFER));
+    vkFreeMemory(logicalDevice, mesh.stagingMemory, hostAllocator.callbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+    vkDestroyBuffer(logicalDevice, mesh.indexBuffer, hostAllocator.callbacks(VK_OBJECT_TYPE_BUFFER));
+    vkFreeMemory(logicalDevice, mesh.indexMemory, hostAllocator.callbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+    vkDestroyBuffer(logicalDevice, mesh.vertexBuffer, hostAllocator.callbacks(VK_OBJECT_TYPE_BUFFER));
+    vkFreeMemory(logicalDevice, mesh.vertexMemory, hostAllocator.callbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+    mesh.uploadPools.clear();
+    mesh.uploadCommandBuffers.clear();
+    mesh.file.close();
+}
+
+bool meshFullyResident(streamed_mesh const& mesh)
+{
+    return mesh.vertexBytesUploaded == static_cast<VkDeviceSize>(mesh.header.vertexCount) * mesh.header.vertexStride
+        && mesh.indexBytesUploaded == static_cast<VkDeviceSize>(mesh.header.indexCount) * mesh.header.indexSize;
+}
+
+VkCommandBuffer streamMeshChunk(streamed_mesh& mesh, VkDevice const& logicalDevice, uint32_t const frameIndex)
+{
+    if(meshFullyResident(mesh))
+    {
+        return VK_NULL_HANDLE;
+    }
+    VkCommandBuffer const commandBuffer = mesh.uploadCommandBuffers[frameIndex];
+    vkResetCommandPool(logicalDevice, mesh.uploadPools[frameIndex], 0);
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    if(VK_FAILED(vkBeginCommandBuffer(commandBuffer, &beginInfo)))
+    {
+        throw std::runtime_error("Failed to begin recording command buffer.");
+    }
+
+    VkDeviceSize const stagingBase = meshStreamChunkSize * frameIndex;
+    VkDeviceSize stagingUsed = 0;
+    auto const streamRegion = [&](uint64_t const fileOffset, VkDeviceSize const regionBytes, VkDeviceSize& uploaded, VkBuffer const& destination, bool const indices)
+    {
+        VkDeviceSize const copyBytes = std::min(regionBytes - uploaded, meshStreamChunkSize - stagingUsed);
+        if(copyBytes == 0)
+        {
+            return;
+        }
+        //checked in the mapping rather than the staging slice, which is slow to read back
+        if(indices)
+        {
+            uint32_t const* const first = reinterpret_cast<uint32_t const*>(mesh.file.data() + fileOffset + uploaded);
+            uint32_t const vertexCount = mesh.header.vertexCount;
+            if(std::any_of(first, first + copyBytes / sizeof(uint32_t), [vertexCount](uint32_t const index) { return index >= vertexCount; }))
+            {
+                throw std::runtime_error("Mesh file indexes past its vertices.");
+            }
+        }
+        //the copy out of the mapping is what faults the file in, the pages are dropped straight after
+        std::memcpy(mesh.stagingMapping + stagingBase + stagingUsed, mesh.file.data() + fileOffset + uploaded, copyBytes);
+        mesh.file.release(fileOffset + uploaded, copyBytes);
+
+        VkBufferCopy copyRegion{};
+        copyRegion.srcOffset = stagingBase + stagingUsed;
+        copyRegion.dstOffset = uploaded;
+        copyRegion.size = copyBytes;
+        vkCmdCopyBuffer(commandBuffer, mesh.stagingBuffer, destination, 1, &copyRegion);
+
+        stagingUsed += copyBytes;
+        uploaded += copyBytes;
+    };
+    streamRegion(mesh.header.vertexOffset, static_cast<VkDeviceSize>(mesh.header.vertexCount) * mesh.header.vertexStride, mesh.vertexBytesUploaded, mesh.vertexBuffer, false);
+    streamRegion(mesh.header.indexOffset, static_cast<VkDeviceSize>(mesh.header.indexCount) * mesh.header.indexSize, mesh.indexBytesUploaded, mesh.indexBuffer, true);
+
+    //draws later in the same submission may read what was just copied
+    VkMemoryBarrier uploadBarrier{};
+    uploadBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    uploadBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    uploadBarrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &uploadBarrier, 0, nullptr, 0, nullptr);
+
+    if(VK_FAILED(vkEndCommandBuffer(commandBuffer)))
+    {
+        throw std::runtime_error("Failed to record command buffer.");
+    }
+
+    //indices only count once every vertex is in, and then only in whole triangles
+    bool const verticesResident = mesh.vertexBytesUploaded == static_cast<VkDeviceSize>(mesh.header.vertexCount) * mesh.header.vertexStride;
+    mesh.residentIndexCount = verticesResident ? static_cast<uint32_t>(mesh.indexBytesUploaded / mesh.header.indexSize / 3 * 3) : 0;
+    return commandBuffer;
+}
+
+graphics_pipeline_description meshPipelineDescription()
+{
+    graphics_pipeline_description reply;
+    reply.vertexShader = "shaders/mesh_vert.spv";
+    //copies are seen from every side
+    reply.cullMode = VK_CULL_MODE_NONE;
+
+    VkVertexInputBindingDescription binding{};
+    binding.binding = 0;
+    binding.stride = sizeof(mesh_vertex);
+    binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    reply.vertexBindings.push_back(binding);
+
+    VkVertexInputAttributeDescription position{};
+    position.binding = 0;
+    position.location = 0;
+    position.format = VK_FORMAT_R32G32B32_SFLOAT;
+    position.offset = offsetof(mesh_vertex, position);
+    reply.vertexAttributes.push_back(position);
+
+    VkVertexInputAttributeDescription color{};
+    color.binding = 0;
+    color.location = 1;
+    color.format = VK_FORMAT_R32G32B32_SFLOAT;
+    color.offset = offsetof(mesh_vertex, color);
+    reply.vertexAttributes.push_back(color);
+
+    VkVertexInputBindingDescription instance{};
+    instance.binding = 1;
+    instance.stride = sizeof(float4x4);
+    instance.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+    reply.vertexBindings.push_back(instance);
+
+    //a mat4 attribute takes one location per column
+    for(uint32_t column = 0; column < 4; ++column)
+    {
+        reply.vertexAttributes.push_back({ 2 + column, 1, VK_FORMAT_R32G32B32A32_SFLOAT, static_cast<uint32_t>(column * 4 * sizeof(float)) });
+    }
+    return reply;
+}
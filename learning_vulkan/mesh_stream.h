@@ -0,0 +1,49 @@
+#pragma once
+
+#include "mesh_file.h"
+#include "vulkan_init.h"
+
+constexpr VkDeviceSize meshStreamChunkSize = 8 * 1024 * 1024;//most bytes copied out of the file in one frame
+
+//a mesh file mapped into memory and copied to device local buffers a chunk per frame. vertices
+//go first so that each level of detail can be drawn as soon as its indices are in.
+struct streamed_mesh
+{
+    mapped_file file;
+    mesh_file_header header{};
+
+    VkBuffer vertexBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory vertexMemory = VK_NULL_HANDLE;
+    VkBuffer indexBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory indexMemory = VK_NULL_HANDLE;
+
+    //one meshStreamChunkSize slice per frame in flight
+    VkBuffer stagingBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory stagingMemory = VK_NULL_HANDLE;
+    uint8_t* stagingMapping = nullptr;
+    vector<VkCommandPool> uploadPools;
+    vector<VkCommandBuffer> uploadCommandBuffers;
+
+    VkDeviceSize vertexBytesUploaded = 0;
+    VkDeviceSize indexBytesUploaded = 0;
+    uint32_t residentIndexCount = 0;//whole triangles only
+};
+
+void openStreamedMesh(streamed_mesh& mesh,
+    std::string const& fileName,
+    VkPhysicalDevice const& physicalDevice,
+    VkDevice const& logicalDevice,
+    queue_family_index_t const graphicsFamily,
+    host_allocator& hostAllocator);
+
+void destroyStreamedMesh(streamed_mesh& mesh, VkDevice const& logicalDevice, host_allocator& hostAllocator);
+
+bool meshFullyResident(streamed_mesh const& mesh);
+
+//records the next chunk of copies for frameIndex, whose previous use must have retired. submit
+//the result ahead of any draws reading the mesh. null once the whole mesh is resident. throws on
+//an index past the vertices, which the gpu would otherwise read outside the vertex buffer for.
+VkCommandBuffer streamMeshChunk(streamed_mesh& mesh, VkDevice const& logicalDevice, uint32_t const frameIndex);
+
+//mesh vertices at binding 0, a clip space transform per instance at binding 1
+graphics_pipeline_description meshPipelineDescription();
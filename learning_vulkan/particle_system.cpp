@@ -0,0 +1,359 @@
+#include "particle_system.h"
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <random>
+
+namespace
+{
+    //a disc of particles on roughly circular orbits, so the simulation stays on screen
+    vector<particle> seedParticles(uint32_t const count)
+    {
+        std::mt19937 random(7);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        vector<particle> reply(count);
+        for(particle& seeded : reply)
+        {
+            float const radius = 0.1f + 0.8f * std::sqrt(unit(random));
+            float const angle = 6.2831853f * unit(random);
+            float const speed = 0.3f / std::sqrt(radius);
+            seeded.position[0] = radius * std::cos(angle);
+            seeded.position[1] = radius * std::sin(angle);
+            seeded.position[2] = 0.0f;
+            seeded.position[3] = 1.0f;
+            seeded.velocity[0] = -speed * std::sin(angle);
+            seeded.velocity[1] = speed * std::cos(angle);
+            seeded.velocity[2] = 0.0f;
+            seeded.velocity[3] = 0.0f;
+        }
+        return reply;
+    }
+
+    void uploadParticles(particle_system& particles,
+        vector<particle> const& seeded,
+        VkPhysicalDevice const& physicalDevice,
+        VkDevice const& logicalDevice,
+        host_allocator& hostAllocator)
+    {
+        VkDeviceSize const halfBytes = sizeof(particle) * static_cast<VkDeviceSize>(particles.capacity);
+        auto const[stagingBuffer, stagingMemory] = createBuffer(physicalDevice,
+            logicalDevice,
+            halfBytes,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            hostAllocator);
+        void* mapping;
+        vkMapMemory(logicalDevice, stagingMemory, 0, halfBytes, 0, &mapping);
+        std::memcpy(mapping, seeded.data(), halfBytes);
+        vkUnmapMemory(logicalDevice, stagingMemory);
+
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = particles.commandPool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = 1;
+        VkCommandBuffer commandBuffer;
+        if(VK_FAILED(vkAllocateCommandBuffers(logicalDevice, &allocInfo, &commandBuffer)))
+        {
+            throw std::runtime_error("Failed to allocate the particle upload command buffer.");
+        }
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(commandBuffer, &beginInfo);
+        //both halves start the same, the first step reads the second
+        std::array<VkBufferCopy, 2> const copies = { { { 0, 0, halfBytes }, { 0, halfBytes, halfBytes } } };
+        vkCmdCopyBuffer(commandBuffer, stagingBuffer, particles.particleBuffer, static_cast<uint32_t>(copies.size()), copies.data());
+        vkEndCommandBuffer(commandBuffer);
+
+        //only at startup, so simply wait for it
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &commandBuffer;
+        if(VK_FAILED(vkQueueSubmit(particles.computeQueue, 1, &submitInfo, VK_NULL_HANDLE)))
+        {
+            throw std::runtime_error("Failed to submit the particle upload.");
+        }
+        vkQueueWaitIdle(particles.computeQueue);
+
+        vkFreeCommandBuffers(logicalDevice, particles.commandPool, 1, &commandBuffer);
+        vkDestroyBuffer(logicalDevice, stagingBuffer, hostAllocator.callbacks(VK_OBJECT_TYPE_BUFFER));
+        vkFreeMemory(logicalDevice, stagingMemory, hostAllocator.callbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+    }
+
+    void createParticleDescriptors(particle_system& particles, VkDevice const& logicalDevice, host_allocator& hostAllocator)
+    {
+        //previous half, next half, control
+        std::array<VkDescriptorSetLayoutBinding, 3> bindings{};
+        for(VkDescriptorSetLayoutBinding& binding : bindings)
+        {
+            binding.binding = static_cast<uint32_t>(&binding - &bindings[0]);
+            binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            binding.descriptorCount = 1;
+            binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        }
+        VkDescriptorSetLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+        layoutInfo.pBindings = bindings.data();
+        if(VK_FAILED(vkCreateDescriptorSetLayout(logicalDevice, &layoutInfo, hostAllocator.callbacks(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT), &particles.descriptorSetLayout)))
+        {
+            throw std::runtime_error("Failed to create the particle descriptor set layout.");
+        }
+
+        VkDescriptorPoolSize const poolSize = { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, static_cast<uint32_t>(bindings.size() * particles.descriptorSets.size()) };
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.maxSets = static_cast<uint32_t>(particles.descriptorSets.size());
+        poolInfo.poolSizeCount = 1;
+        poolInfo.pPoolSizes = &poolSize;
+        if(VK_FAILED(vkCreateDescriptorPool(logicalDevice, &poolInfo, hostAllocator.callbacks(VK_OBJECT_TYPE_DESCRIPTOR_POOL), &particles.descriptorPool)))
+        {
+            throw std::runtime_error("Failed to create the particle descriptor pool.");
+        }
+
+        std::array<VkDescriptorSetLayout, 2> const setLayouts = { particles.descriptorSetLayout, particles.descriptorSetLayout };
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = particles.descriptorPool;
+        allocInfo.descriptorSetCount = static_cast<uint32_t>(setLayouts.size());
+        allocInfo.pSetLayouts = setLayouts.data();
+        if(VK_FAILED(vkAllocateDescriptorSets(logicalDevice, &allocInfo, particles.descriptorSets.data())))
+        {
+            throw std::runtime_error("Failed to allocate the particle descriptor sets.");
+        }
+
+        VkDeviceSize const halfBytes = sizeof(particle) * static_cast<VkDeviceSize>(particles.capacity);
+        for(uint32_t half = 0; half < 2; ++half)
+        {
+            std::array<VkDescriptorBufferInfo, 3> const buffers =
+            { {
+                { particles.particleBuffer, (half ^ 1) * halfBytes, halfBytes },
+                { particles.particleBuffer, half * halfBytes, halfBytes },
+                { particles.controlBuffer, half * particles.controlStride, sizeof(particle_control) },
+            } };
+            std::array<VkWriteDescriptorSet, 3> writes{};
+            for(VkWriteDescriptorSet& write : writes)
+            {
+                uint32_t const binding = static_cast<uint32_t>(&write - &writes[0]);
+                write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                write.dstSet = particles.descriptorSets[half];
+                write.dstBinding = binding;
+                write.descriptorCount = 1;
+                write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                write.pBufferInfo = &buffers[binding];
+            }
+            vkUpdateDescriptorSets(logicalDevice, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+        }
+    }
+
+    void recordParticleSteps(particle_system& particles, VkDevice const& logicalDevice)
+    {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = particles.commandPool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = static_cast<uint32_t>(particles.commandBuffers.size());
+        if(VK_FAILED(vkAllocateCommandBuffers(logicalDevice, &allocInfo, particles.commandBuffers.data())))
+        {
+            throw std::runtime_error("Failed to allocate the particle command buffers.");
+        }
+
+        for(uint32_t half = 0; half < 2; ++half)
+        {
+            VkCommandBuffer const& commandBuffer = particles.commandBuffers[half];
+            VkCommandBufferBeginInfo beginInfo{};
+            beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            if(VK_FAILED(vkBeginCommandBuffer(commandBuffer, &beginInfo)))
+            {
+                throw std::runtime_error("Failed to begin recording a particle step.");
+            }
+            if(particles.timestamps != VK_NULL_HANDLE)
+            {
+                vkCmdResetQueryPool(commandBuffer, particles.timestamps, half * 2, 2);
+                vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, particles.timestamps, half * 2);
+            }
+
+            //the previous step on this queue wrote what this one reads
+            VkMemoryBarrier previousStep{};
+            previousStep.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            previousStep.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+            previousStep.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &previousStep, 0, nullptr, 0, nullptr);
+
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, particles.pipeline);
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, particles.pipelineLayout, 0, 1, &particles.descriptorSets[half], 0, nullptr);
+            vkCmdDispatchIndirect(commandBuffer, particles.controlBuffer, half * particles.controlStride + offsetof(particle_control, dispatch));
+
+            if(particles.timestamps != VK_NULL_HANDLE)
+            {
+                vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, particles.timestamps, half * 2 + 1);
+            }
+            if(VK_FAILED(vkEndCommandBuffer(commandBuffer)))
+            {
+                throw std::runtime_error("Failed to record a particle step.");
+            }
+        }
+    }
+}
+
+void createParticleSystem(particle_system& particles,
+    uint32_t const capacity,
+    VkPhysicalDevice const& physicalDevice,
+    VkDevice const& logicalDevice,
+    queue_family_index_t const graphicsFamily,
+    queue_family_index_t const computeFamily,
+    host_allocator& hostAllocator)
+{
+    particles.capacity = (capacity + particleWorkgroupSize - 1) / particleWorkgroupSize * particleWorkgroupSize;
+    particles.computeFamily = computeFamily;
+    vkGetDeviceQueue(logicalDevice, computeFamily, 0, &particles.computeQueue);
+
+    //written on the compute queue and drawn from on the graphics queue. concurrent sharing saves
+    //an ownership transfer on both queues every step.
+    VkDeviceSize const halfBytes = sizeof(particle) * static_cast<VkDeviceSize>(particles.capacity);
+    std::tie(particles.particleBuffer, particles.particleMemory) = createBuffer(physicalDevice,
+        logicalDevice,
+        halfBytes * 2,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        hostAllocator,
+        { graphicsFamily, computeFamily });
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    VkDeviceSize const alignment = properties.limits.minStorageBufferOffsetAlignment;
+    particles.controlStride = (sizeof(particle_control) + alignment - 1) / alignment * alignment;
+    std::tie(particles.controlBuffer, particles.controlMemory) = createBuffer(physicalDevice,
+        logicalDevice,
+        particles.controlStride * 2,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        hostAllocator);
+    void* controlMapping;
+    vkMapMemory(logicalDevice, particles.controlMemory, 0, particles.controlStride * 2, 0, &controlMapping);
+    particles.controlMapping = static_cast<uint8_t*>(controlMapping);
+
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+    vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+    if(queueFamilies[computeFamily].timestampValidBits > 0)
+    {
+        particles.timestampPeriod = properties.limits.timestampPeriod;
+        VkQueryPoolCreateInfo timestampInfo{};
+        timestampInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        timestampInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        timestampInfo.queryCount = 4;
+        if(VK_FAILED(vkCreateQueryPool(logicalDevice, &timestampInfo, hostAllocator.callbacks(VK_OBJECT_TYPE_QUERY_POOL), &particles.timestamps)))
+        {
+            throw std::runtime_error("Failed to create the particle timestamp query pool.");
+        }
+    }
+
+    createParticleDescriptors(particles, logicalDevice, hostAllocator);
+    std::tie(particles.pipeline, particles.pipelineLayout) = createComputePipeline(logicalDevice, "shaders/particles_comp.spv", { particles.descriptorSetLayout }, VK_NULL_HANDLE, hostAllocator);
+
+    particles.commandPool = createCommandPool(logicalDevice, computeFamily, hostAllocator);
+    uploadParticles(particles, seedParticles(particles.capacity), physicalDevice, logicalDevice, hostAllocator);
+    recordParticleSteps(particles, logicalDevice);
+
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    particles.stepFinishedSemaphores.resize(maxFramesInFlight);
+    for(VkSemaphore& semaphore : particles.stepFinishedSemaphores)
+    {
+        if(VK_FAILED(vkCreateSemaphore(logicalDevice, &semaphoreInfo, hostAllocator.callbacks(VK_OBJECT_TYPE_SEMAPHORE), &semaphore)))
+        {
+            throw std::runtime_error("Failed to create the particle semaphores.");
+        }
+    }
+}
+
+void destroyParticleSystem(particle_system& particles, VkDevice const& logicalDevice, host_allocator& hostAllocator)
+{
+    for(VkSemaphore const& semaphore : particles.stepFinishedSemaphores)
+    {
+        vkDestroySemaphore(logicalDevice, semaphore, hostAllocator.callbacks(VK_OBJECT_TYPE_SEMAPHORE));
+    }
+    vkDestroyCommandPool(logicalDevice, particles.commandPool, hostAllocator.callbacks(VK_OBJECT_TYPE_COMMAND_POOL));
+    vkDestroyPipeline(logicalDevice, particles.pipeline, hostAllocator.callbacks(VK_OBJECT_TYPE_PIPELINE));
+    vkDestroyPipelineLayout(logicalDevice, particles.pipelineLayout, hostAllocator.callbacks(VK_OBJECT_TYPE_PIPELINE_LAYOUT));
+    vkDestroyDescriptorPool(logicalDevice, particles.descriptorPool, hostAllocator.callbacks(VK_OBJECT_TYPE_DESCRIPTOR_POOL));
+    vkDestroyDescriptorSetLayout(logicalDevice, particles.descriptorSetLayout, hostAllocator.callbacks(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT));
+    if(particles.timestamps != VK_NULL_HANDLE)
+    {
+        vkDestroyQueryPool(logicalDevice, particles.timestamps, hostAllocator.callbacks(VK_OBJECT_TYPE_QUERY_POOL));
+    }
+    vkUnmapMemory(logicalDevice, particles.controlMemory);
+    vkDestroyBuffer(logicalDevice, particles.controlBuffer, hostAllocator.callbacks(VK_OBJECT_TYPE_BUFFER));
+    vkFreeMemory(logicalDevice, particles.controlMemory, hostAllocator.callbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+    vkDestroyBuffer(logicalDevice, particles.particleBuffer, hostAllocator.callbacks(VK_OBJECT_TYPE_BUFFER));
+    vkFreeMemory(logicalDevice, particles.particleMemory, hostAllocator.callbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+    particles.stepFinishedSemaphores.clear();
+}
+
+VkSemaphore stepParticles(particle_system& particles, uint32_t const count, uint32_t const frameIndex)
+{
+    //the step that last used this half belonged to a frame that has retired, so its control is free
+    uint32_t const half = static_cast<uint32_t>(particles.stepCount % 2);
+    particles.activeCount = std::min(count, particles.capacity);
+    particle_control control{};
+    control.dispatch = { (particles.activeCount + particleWorkgroupSize - 1) / particleWorkgroupSize, 1, 1 };
+    control.count = particles.activeCount;
+    control.deltaSeconds = particleStepSeconds;
+    std::memcpy(particles.controlMapping + half * particles.controlStride, &control, sizeof(control));
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &particles.commandBuffers[half];
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &particles.stepFinishedSemaphores[frameIndex];
+    if(VK_FAILED(vkQueueSubmit(particles.computeQueue, 1, &submitInfo, VK_NULL_HANDLE)))
+    {
+        throw std::runtime_error("Failed to submit a particle step.");
+    }
+    ++particles.stepCount;
+    return particles.stepFinishedSemaphores[frameIndex];
+}
+
+uint32_t particleFirstVertex(particle_system const& particles)
+{
+    return static_cast<uint32_t>((particles.stepCount + 1) % 2) * particles.capacity;
+}
+
+bool readParticleStepTime(particle_system const& particles, VkDevice const& logicalDevice, uint32_t const half, double& milliseconds)
+{
+    if(particles.timestamps == VK_NULL_HANDLE)
+    {
+        return false;
+    }
+    std::array<uint64_t, 2> ticks{};
+    if(vkGetQueryPoolResults(logicalDevice, particles.timestamps, half * 2, 2,
+        sizeof(ticks), ticks.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+    {
+        return false;
+    }
+    milliseconds = static_cast<double>(ticks[1] - ticks[0]) * particles.timestampPeriod / 1e6;
+    return true;
+}
+
+graphics_pipeline_description particlePipelineDescription()
+{
+    graphics_pipeline_description reply;
+    reply.vertexShader = "shaders/particles_vert.spv";
+    reply.topology = VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+    reply.cullMode = VK_CULL_MODE_NONE;
+
+    VkVertexInputBindingDescription binding{};
+    binding.binding = 0;
+    binding.stride = sizeof(particle);
+    binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    reply.vertexBindings.push_back(binding);
+
+    reply.vertexAttributes.push_back({ 0, 0, VK_FORMAT_R32G32B32A32_SFLOAT, static_cast<uint32_t>(offsetof(particle, position)) });
+    reply.vertexAttributes.push_back({ 1, 0, VK_FORMAT_R32G32B32A32_SFLOAT, static_cast<uint32_t>(offsetof(particle, velocity)) });
+    return reply;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "vulkan_init.h"
+
+#include <array>
+
+constexpr uint32_t particleWorkgroupSize = 256;//matches local_size_x in particles.comp
+constexpr float particleStepSeconds = 1.0f / 120.0f;
+constexpr uint32_t particleBenchmarkMinimumCount = 65536;//the sweep multiplies by four from here
+constexpr uint32_t particleBenchmarkMaximumCount = 4194304;//capacity when --particles isn't given
+constexpr uint32_t particleBenchmarkWarmupFrames = 8;//frames after a count change that aren't measured
+
+//matches the shaders, position.w and velocity.w are spare
+struct particle
+{
+    float position[4];
+    float velocity[4];
+};
+
+//what one step dispatches and simulates. host visible and read by the gpu from the buffer, so the
+//live count can change every frame without re-recording anything. matches Control in particles.comp.
+struct particle_control
+{
+    VkDispatchIndirectCommand dispatch;
+    uint32_t count;
+    float deltaSeconds;
+};
+
+//particles live in two halves of one buffer. step n reads half (n + 1) % 2 and writes half n % 2
+//on the compute queue while the graphics queue may still be drawing step n - 1 from the other
+//half, with a semaphore handing each step over to the frame that draws it.
+struct particle_system
+{
+    uint32_t capacity = 0;//per half, a whole number of workgroups
+    queue_family_index_t computeFamily = 0;
+    VkQueue computeQueue = VK_NULL_HANDLE;
+
+    VkBuffer particleBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory particleMemory = VK_NULL_HANDLE;
+    VkBuffer controlBuffer = VK_NULL_HANDLE;//one particle_control per half, controlStride apart
+    VkDeviceMemory controlMemory = VK_NULL_HANDLE;
+    uint8_t* controlMapping = nullptr;
+    VkDeviceSize controlStride = 0;
+
+    VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    std::array<VkDescriptorSet, 2> descriptorSets{};//indexed by the half written
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    std::array<VkCommandBuffer, 2> commandBuffers{};//prerecorded, indexed by the half written
+    vector<VkSemaphore> stepFinishedSemaphores;//one per frame in flight
+    VkQueryPool timestamps = VK_NULL_HANDLE;//two per half, null when the compute queue can't write them
+    float timestampPeriod = 0.0f;
+
+    uint64_t stepCount = 0;
+    uint32_t activeCount = 0;
+};
+
+//seeds capacity particles in a disc on orbits around the middle of the screen
+void createParticleSystem(particle_system& particles,
+    uint32_t const capacity,
+    VkPhysicalDevice const& physicalDevice,
+    VkDevice const& logicalDevice,
+    queue_family_index_t const graphicsFamily,
+    queue_family_index_t const computeFamily,
+    host_allocator& hostAllocator);
+
+void destroyParticleSystem(particle_system& particles, VkDevice const& logicalDevice, host_allocator& hostAllocator);
+
+//submits the next step for count particles to the compute queue, signalling the frame's semaphore.
+//frameIndex's previous frame must have retired. returns the semaphore to wait on at vertex input.
+VkSemaphore stepParticles(particle_system& particles, uint32_t const count, uint32_t const frameIndex);
+
+//the half the latest step wrote, as a first vertex for the draw
+uint32_t particleFirstVertex(particle_system const& particles);
+
+//gpu time of the step that last wrote half, once the frame it belonged to has retired
+bool readParticleStepTime(particle_system const& particles, VkDevice const& logicalDevice, uint32_t const half, double& milliseconds);
+
+graphics_pipeline_description particlePipelineDescription();
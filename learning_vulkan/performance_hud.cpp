@@ -0,0 +1,434 @@
+#include "performance_hud.h"
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+    //the classic 5x7 font, a byte per column from the left with the top row in the low bit
+    constexpr uint8_t hudFont[hudSolidGlyph][5] =
+    {
+        { 0x00, 0x00, 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x5F, 0x00, 0x00 }, { 0x00, 0x07, 0x00, 0x07, 0x00 }, { 0x14, 0x7F, 0x14, 0x7F, 0x14 },// !"#
+        { 0x24, 0x2A, 0x7F, 0x2A, 0x12 }, { 0x23, 0x13, 0x08, 0x64, 0x62 }, { 0x36, 0x49, 0x55, 0x22, 0x50 }, { 0x00, 0x05, 0x03, 0x00, 0x00 },//$%&'
+        { 0x00, 0x1C, 0x22, 0x41, 0x00 }, { 0x00, 0x41, 0x22, 0x1C, 0x00 }, { 0x08, 0x2A, 0x1C, 0x2A, 0x08 }, { 0x08, 0x08, 0x3E, 0x08, 0x08 },//()*+
+        { 0x00, 0x50, 0x30, 0x00, 0x00 }, { 0x08, 0x08, 0x08, 0x08, 0x08 }, { 0x00, 0x60, 0x60, 0x00, 0x00 }, { 0x20, 0x10, 0x08, 0x04, 0x02 },//,-./
+        { 0x3E, 0x51, 0x49, 0x45, 0x3E }, { 0x00, 0x42, 0x7F, 0x40, 0x00 }, { 0x42, 0x61, 0x51, 0x49, 0x46 }, { 0x21, 0x41, 0x45, 0x4B, 0x31 },//0123
+        { 0x18, 0x14, 0x12, 0x7F, 0x10 }, { 0x27, 0x45, 0x45, 0x45, 0x39 }, { 0x3C, 0x4A, 0x49, 0x49, 0x30 }, { 0x01, 0x71, 0x09, 0x05, 0x03 },//4567
+        { 0x36, 0x49, 0x49, 0x49, 0x36 }, { 0x06, 0x49, 0x49, 0x29, 0x1E }, { 0x00, 0x36, 0x36, 0x00, 0x00 }, { 0x00, 0x56, 0x36, 0x00, 0x00 },//89:;
+        { 0x00, 0x08, 0x14, 0x22, 0x41 }, { 0x14, 0x14, 0x14, 0x14, 0x14 }, { 0x41, 0x22, 0x14, 0x08, 0x00 }, { 0x02, 0x01, 0x51, 0x09, 0x06 },//<=>?
+        { 0x32, 0x49, 0x79, 0x41, 0x3E }, { 0x7E, 0x11, 0x11, 0x11, 0x7E }, { 0x7F, 0x49, 0x49, 0x49, 0x36 }, { 0x3E, 0x41, 0x41, 0x41, 0x22 },//@ABC
+        { 0x7F, 0x41, 0x41, 0x22, 0x1C }, { 0x7F, 0x49, 0x49, 0x49, 0x41 }, { 0x7F, 0x09, 0x09, 0x01, 0x01 }, { 0x3E, 0x41, 0x41, 0x51, 0x32 },//DEFG
+        { 0x7F, 0x08, 0x08, 0x08, 0x7F }, { 0x00, 0x41, 0x7F, 0x41, 0x00 }, { 0x20, 0x40, 0x41, 0x3F, 0x01 }, { 0x7F, 0x08, 0x14, 0x22, 0x41 },//HIJK
+        { 0x7F, 0x40, 0x40, 0x40, 0x40 }, { 0x7F, 0x02, 0x04, 0x02, 0x7F }, { 0x7F, 0x04, 0x08, 0x10, 0x7F }, { 0x3E, 0x41, 0x41, 0x41, 0x3E },//LMNO
+        { 0x7F, 0x09, 0x09, 0x09, 0x06 }, { 0x3E, 0x41, 0x51, 0x21, 0x5E }, { 0x7F, 0x09, 0x19, 0x29, 0x46 }, { 0x46, 0x49, 0x49, 0x49, 0x31 },//PQRS
+        { 0x01, 0x01, 0x7F, 0x01, 0x01 }, { 0x3F, 0x40, 0x40, 0x40, 0x3F }, { 0x1F, 0x20, 0x40, 0x20, 0x1F }, { 0x7F, 0x20, 0x18, 0x20, 0x7F },//TUVW
+        { 0x63, 0x14, 0x08, 0x14, 0x63 }, { 0x03, 0x04, 0x78, 0x04, 0x03 }, { 0x61, 0x51, 0x49, 0x45, 0x43 }, { 0x00, 0x00, 0x7F, 0x41, 0x41 },//XYZ[
+        { 0x02, 0x04, 0x08, 0x10, 0x20 }, { 0x41, 0x41, 0x7F, 0x00, 0x00 }, { 0x04, 0x02, 0x01, 0x02, 0x04 }, { 0x40, 0x40, 0x40, 0x40, 0x40 },//\]^_
+    };
+    constexpr uint32_t hudGlyphAdvance = 6;//atlas pixels from one character to the next
+    constexpr uint32_t hudLineAdvance = 10;
+    constexpr uint32_t hudPanelColumns = 36;//characters in the widest line
+    constexpr uint32_t hudPanelLines = 11;
+    constexpr uint32_t hudGraphHeight = 32;//atlas pixels, so it scales with the text
+    constexpr float hudFrameBudgetMilliseconds = 1000.0f / 60.0f;//where the graph's line is drawn
+
+    constexpr uint32_t hudColor(uint32_t const red, uint32_t const green, uint32_t const blue, uint32_t const alpha)
+    {
+        return red | (green << 8) | (blue << 16) | (alpha << 24);
+    }
+    constexpr uint32_t hudPanelColor = hudColor(0, 0, 0, 176);
+    constexpr uint32_t hudTextColor = hudColor(230, 230, 230, 255);
+    constexpr uint32_t hudHeadingColor = hudColor(255, 200, 80, 255);
+    constexpr uint32_t hudGoodColor = hudColor(80, 220, 100, 255);
+    constexpr uint32_t hudSlowColor = hudColor(240, 200, 60, 255);
+    constexpr uint32_t hudBadColor = hudColor(240, 70, 60, 255);
+
+    vector<uint8_t> rasteriseAtlas()
+    {
+        uint32_t const width = hudAtlasColumns * hudGlyphPixels;
+        vector<uint8_t> reply(width * hudAtlasRows * hudGlyphPixels, 0);
+        for(uint32_t glyph = 0; glyph < hudSolidGlyph; ++glyph)
+        {
+            uint32_t const left = glyph % hudAtlasColumns * hudGlyphPixels;
+            uint32_t const top = glyph / hudAtlasColumns * hudGlyphPixels;
+            for(uint32_t column = 0; column < 5; ++column)
+            {
+                for(uint32_t row = 0; row < 7; ++row)
+                {
+                    if((hudFont[glyph][column] >> row) & 1)
+                    {
+                        reply[(top + row) * width + left + column] = 255;
+                    }
+                }
+            }
+        }
+        uint32_t const solidLeft = hudSolidGlyph % hudAtlasColumns * hudGlyphPixels;
+        uint32_t const solidTop = hudSolidGlyph / hudAtlasColumns * hudGlyphPixels;
+        for(uint32_t row = 0; row < hudGlyphPixels; ++row)
+        {
+            std::memset(&reply[(solidTop + row) * width + solidLeft], 255, hudGlyphPixels);
+        }
+        return reply;
+    }
+
+    void uploadAtlas(hud_atlas const& atlas,
+        vector<uint8_t> const& texels,
+        VkPhysicalDevice const& physicalDevice,
+        VkDevice const& logicalDevice,
+        VkQueue const& graphicsQueue,
+        VkCommandPool const& commandPool,
+        host_allocator& hostAllocator)
+    {
+        auto const[stagingBuffer, stagingMemory] = createBuffer(physicalDevice,
+            logicalDevice,
+            texels.size(),
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            hostAllocator);
+        void* mapping;
+        vkMapMemory(logicalDevice, stagingMemory, 0, texels.size(), 0, &mapping);
+        std::memcpy(mapping, texels.data(), texels.size());
+        vkUnmapMemory(logicalDevice, stagingMemory);
+
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = commandPool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = 1;
+        VkCommandBuffer commandBuffer;
+        if(VK_FAILED(vkAllocateCommandBuffers(logicalDevice, &allocInfo, &commandBuffer)))
+        {
+            throw std::runtime_error("Failed to allocate the hud upload command buffer.");
+        }
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = atlas.image;
+        barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        VkBufferImageCopy copy{};
+        copy.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+        copy.imageExtent = { hudAtlasColumns * hudGlyphPixels, hudAtlasRows * hudGlyphPixels, 1 };
+        vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, atlas.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy);
+
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+        vkEndCommandBuffer(commandBuffer);
+
+        //only at startup, so simply wait for it
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &commandBuffer;
+        if(VK_FAILED(vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE)))
+        {
+            throw std::runtime_error("Failed to submit the hud upload.");
+        }
+        vkQueueWaitIdle(graphicsQueue);
+
+        vkFreeCommandBuffers(logicalDevice, commandPool, 1, &commandBuffer);
+        vkDestroyBuffer(logicalDevice, stagingBuffer, hostAllocator.callbacks(VK_OBJECT_TYPE_BUFFER));
+        vkFreeMemory(logicalDevice, stagingMemory, hostAllocator.callbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+    }
+
+    void createAtlasDescriptors(hud_atlas& atlas, VkDevice const& logicalDevice, host_allocator& hostAllocator)
+    {
+        VkSamplerCreateInfo samplerInfo{};
+        samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerInfo.magFilter = VK_FILTER_NEAREST;
+        samplerInfo.minFilter = VK_FILTER_NEAREST;
+        samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        if(VK_FAILED(vkCreateSampler(logicalDevice, &samplerInfo, hostAllocator.callbacks(VK_OBJECT_TYPE_SAMPLER), &atlas.sampler)))
+        {
+            throw std::runtime_error("Failed to create the hud sampler.");
+        }
+
+        VkDescriptorSetLayoutBinding binding{};
+        binding.binding = 0;
+        binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        binding.descriptorCount = 1;
+        binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+        VkDescriptorSetLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = 1;
+        layoutInfo.pBindings = &binding;
+        if(VK_FAILED(vkCreateDescriptorSetLayout(logicalDevice, &layoutInfo, hostAllocator.callbacks(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT), &atlas.descriptorSetLayout)))
+        {
+            throw std::runtime_error("Failed to create the hud descriptor set layout.");
+        }
+
+        VkDescriptorPoolSize const poolSize = { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1 };
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.maxSets = 1;
+        poolInfo.poolSizeCount = 1;
+        poolInfo.pPoolSizes = &poolSize;
+        if(VK_FAILED(vkCreateDescriptorPool(logicalDevice, &poolInfo, hostAllocator.callbacks(VK_OBJECT_TYPE_DESCRIPTOR_POOL), &atlas.descriptorPool)))
+        {
+            throw std::runtime_error("Failed to create the hud descriptor pool.");
+        }
+
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = atlas.descriptorPool;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &atlas.descriptorSetLayout;
+        if(VK_FAILED(vkAllocateDescriptorSets(logicalDevice, &allocInfo, &atlas.descriptorSet)))
+        {
+            throw std::runtime_error("Failed to allocate the hud descriptor set.");
+        }
+
+        VkDescriptorImageInfo const imageInfo = { atlas.sampler, atlas.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = atlas.descriptorSet;
+        write.dstBinding = 0;
+        write.descriptorCount = 1;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        write.pImageInfo = &imageInfo;
+        vkUpdateDescriptorSets(logicalDevice, 1, &write, 0, nullptr);
+    }
+
+    //places quads in screen pixels from the top left, dropping whatever doesn't fit
+    struct hud_layout
+    {
+        hud_quad* quads;
+        uint32_t capacity;
+        uint32_t count;
+        float pixelWidth;//of one screen pixel in normalised device coordinates
+        float pixelHeight;
+        float scale;
+
+        void quad(float const x, float const y, float const width, float const height, uint32_t const glyph, uint32_t const color)
+        {
+            if(count < capacity)
+            {
+                quads[count++] = { { x * pixelWidth - 1.0f, y * pixelHeight - 1.0f, width * pixelWidth, height * pixelHeight }, glyph, color };
+            }
+        }
+
+        void text(float x, float const y, char const* text, uint32_t const color)
+        {
+            for(; *text != '\0'; ++text, x += hudGlyphAdvance * scale)
+            {
+                uint32_t character = static_cast<unsigned char>(*text);
+                if(character >= 'a' && character <= 'z')
+                {
+                    character -= 'a' - 'A';
+                }
+                else if(character < hudFirstGlyph || character >= hudFirstGlyph + hudSolidGlyph)
+                {
+                    character = '?';
+                }
+                //spaces would only be transparent quads
+                if(character != ' ')
+                {
+                    quad(x, y, hudGlyphPixels * scale, hudGlyphPixels * scale, character - hudFirstGlyph, color);
+                }
+            }
+        }
+    };
+
+    uint32_t frameTimeColor(float const milliseconds)
+    {
+        if(milliseconds <= hudFrameBudgetMilliseconds * 1.05f)
+        {
+            return hudGoodColor;
+        }
+        return milliseconds <= hudFrameBudgetMilliseconds * 2.05f ? hudSlowColor : hudBadColor;
+    }
+}
+
+void pushFrameTime(frame_timings& timings, float const milliseconds)
+{
+    timings.frameMilliseconds[timings.frameCount % hudHistoryFrames] = milliseconds;
+    ++timings.frameCount;
+}
+
+void createHudAtlas(hud_atlas& atlas,
+    VkPhysicalDevice const& physicalDevice,
+    VkDevice const& logicalDevice,
+    VkQueue const& graphicsQueue,
+    VkCommandPool const& commandPool,
+    host_allocator& hostAllocator)
+{
+    std::tie(atlas.image, atlas.memory) = createImage(physicalDevice,
+        logicalDevice,
+        { hudAtlasColumns * hudGlyphPixels, hudAtlasRows * hudGlyphPixels },
+        1,
+        VK_FORMAT_R8_UNORM,
+        VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        hostAllocator);
+    uploadAtlas(atlas, rasteriseAtlas(), physicalDevice, logicalDevice, graphicsQueue, commandPool, hostAllocator);
+    atlas.view = createImageView(atlas.image, VK_FORMAT_R8_UNORM, 1, logicalDevice, hostAllocator);
+    createAtlasDescriptors(atlas, logicalDevice, hostAllocator);
+}
+
+void destroyHudAtlas(hud_atlas& atlas, VkDevice const& logicalDevice, host_allocator& hostAllocator)
+{
+    vkDestroyDescriptorPool(logicalDevice, atlas.descriptorPool, hostAllocator.callbacks(VK_OBJECT_TYPE_DESCRIPTOR_POOL));
+    vkDestroyDescriptorSetLayout(logicalDevice, atlas.descriptorSetLayout, hostAllocator.callbacks(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT));
+    vkDestroySampler(logicalDevice, atlas.sampler, hostAllocator.callbacks(VK_OBJECT_TYPE_SAMPLER));
+    vkDestroyImageView(logicalDevice, atlas.view, hostAllocator.callbacks(VK_OBJECT_TYPE_IMAGE_VIEW));
+    vkDestroyImage(logicalDevice, atlas.image, hostAllocator.callbacks(VK_OBJECT_TYPE_IMAGE));
+    vkFreeMemory(logicalDevice, atlas.memory, hostAllocator.callbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+    atlas = hud_atlas{};
+}
+
+graphics_pipeline_description hudPipelineDescription(hud_atlas const& atlas)
+{
+    graphics_pipeline_description reply;
+    reply.vertexShader = "shaders/hud_vert.spv";
+    reply.fragmentShader = "shaders/hud_frag.spv";
+    reply.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+    reply.cullMode = VK_CULL_MODE_NONE;
+    reply.alphaBlend = true;
+    reply.setLayouts.push_back(atlas.descriptorSetLayout);
+
+    VkVertexInputBindingDescription binding{};
+    binding.binding = 0;
+    binding.stride = sizeof(hud_quad);
+    binding.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+    reply.vertexBindings.push_back(binding);
+
+    reply.vertexAttributes.push_back({ 0, 0, VK_FORMAT_R32G32B32A32_SFLOAT, static_cast<uint32_t>(offsetof(hud_quad, rect)) });
+    reply.vertexAttributes.push_back({ 1, 0, VK_FORMAT_R32_UINT, static_cast<uint32_t>(offsetof(hud_quad, glyph)) });
+    reply.vertexAttributes.push_back({ 2, 0, VK_FORMAT_R8G8B8A8_UNORM, static_cast<uint32_t>(offsetof(hud_quad, color)) });
+    return reply;
+}
+
+uint32_t writeHudQuads(hud_quad* quads,
+    uint32_t const capacity,
+    VkExtent2D const& extent,
+    uint32_t const scale,
+    frame_stats const& stats,
+    frame_timings const& timings)
+{
+    hud_layout layout = { quads, capacity, 0, 2.0f / extent.width, 2.0f / extent.height, static_cast<float>(scale) };
+    float const margin = 4.0f * scale;
+    float const line = static_cast<float>(hudLineAdvance * scale);
+    float const graphHeight = static_cast<float>(hudGraphHeight * scale);
+    float const panelWidth = hudPanelColumns * hudGlyphAdvance * scale + 2.0f * margin;
+    float const panelHeight = hudPanelLines * line + graphHeight + 3.0f * margin;
+    float const left = margin;
+    float y = margin;
+    layout.quad(0.0f, 0.0f, panelWidth, panelHeight, hudSolidGlyph, hudPanelColor);
+
+    //the graph is over the history, the text only the latest frame
+    uint32_t const samples = static_cast<uint32_t>(std::min<uint64_t>(timings.frameCount, hudHistoryFrames));
+    float slowest = 0.0f;
+    float total = 0.0f;
+    for(uint32_t i = 0; i < samples; ++i)
+    {
+        slowest = std::max(slowest, timings.frameMilliseconds[i]);
+        total += timings.frameMilliseconds[i];
+    }
+    float const latest = samples > 0 ? timings.frameMilliseconds[(timings.frameCount - 1) % hudHistoryFrames] : 0.0f;
+    char text[64];
+    std::snprintf(text, sizeof(text), "FRAME %6.2f MS  AVG %5.2f MAX %5.2f", latest, samples > 0 ? total / samples : 0.0f, slowest);
+    layout.text(left, y, text, hudHeadingColor);
+    y += line;
+
+    float const graphWidth = panelWidth - 2.0f * margin;
+    float const barWidth = graphWidth / hudHistoryFrames;
+    float const graphTop = y;
+    float const graphRange = std::max(slowest, 2.0f * hudFrameBudgetMilliseconds);
+    for(uint32_t i = 0; i < samples; ++i)
+    {
+        float const milliseconds = timings.frameMilliseconds[(timings.frameCount - samples + i) % hudHistoryFrames];
+        float const barHeight = std::max(graphHeight * milliseconds / graphRange, 1.0f);
+        layout.quad(left + i * barWidth, graphTop + graphHeight - barHeight, std::max(barWidth - 1.0f, 1.0f), barHeight, hudSolidGlyph, frameTimeColor(milliseconds));
+    }
+    float const budgetY = graphTop + graphHeight * (1.0f - hudFrameBudgetMilliseconds / graphRange);
+    layout.quad(left, budgetY, graphWidth, 1.0f, hudSolidGlyph, hudColor(255, 255, 255, 96));
+    y += graphHeight + margin;
+
+    std::snprintf(text, sizeof(text), "CPU WAIT %5.2f ACQUIRE %5.2f", timings.waitMilliseconds, timings.acquireMilliseconds);
+    layout.text(left, y, text, hudTextColor);
+    y += line;
+    std::snprintf(text, sizeof(text), "    CULL %5.2f RECORD  %5.2f", timings.cullMilliseconds, timings.recordMilliseconds);
+    layout.text(left, y, text, hudTextColor);
+    y += line;
+    std::snprintf(text, sizeof(text), "  SUBMIT %5.2f HUD     %5.2f", timings.submitMilliseconds, timings.hudMilliseconds);
+    layout.text(left, y, text, hudTextColor);
+    y += line;
+
+    if(stats.gpuTimeValid)
+    {
+        std::snprintf(text, sizeof(text), "GPU %6.2f MS  SCALE %3.0f%%", stats.gpuMilliseconds, stats.resolutionScale * 100.0f);
+    }
+    else
+    {
+        std::snprintf(text, sizeof(text), "GPU    N/A     SCALE %3.0f%%", stats.resolutionScale * 100.0f);
+    }
+    layout.text(left, y, text, hudTextColor);
+    y += line;
+    if(timings.computeValid)
+    {
+        std::snprintf(text, sizeof(text), "COMPUTE %6.2f MS", timings.computeMilliseconds);
+        layout.text(left, y, text, hudTextColor);
+    }
+    y += line;
+
+    std::snprintf(text, sizeof(text), "DRAWS %u BINDS %u SAVED %u", stats.draws, stats.pipelineBinds + stats.descriptorBinds + stats.vertexBinds + stats.indexBinds, stats.bindsSaved);
+    layout.text(left, y, text, hudTextColor);
+    y += line;
+    if(stats.pipelineStatisticsValid)
+    {
+        std::snprintf(text, sizeof(text), "TRIS %llu VERTS %llu", static_cast<unsigned long long>(stats.inputAssemblyPrimitives), static_cast<unsigned long long>(stats.inputAssemblyVertices));
+    }
+    else
+    {
+        std::snprintf(text, sizeof(text), "TRIS N/A");
+    }
+    layout.text(left, y, text, hudTextColor);
+    y += line;
+    if(stats.meshLodValid)
+    {
+        std::snprintf(text, sizeof(text), "LOD TRIS %llu OF %llu", static_cast<unsigned long long>(stats.meshTriangles), static_cast<unsigned long long>(stats.meshFullDetailTriangles));
+        layout.text(left, y, text, hudTextColor);
+    }
+    y += line;
+
+    //device local heaps together, at most memoryBudgetInterval frames old
+    VkDeviceSize usage = 0;
+    VkDeviceSize budget = 0;
+    for(uint32_t i = 0; i < stats.heapCount; ++i)
+    {
+        if(stats.heaps[i].deviceLocal)
+        {
+            usage += stats.heaps[i].usage;
+            budget += stats.heaps[i].budget;
+        }
+    }
+    if(stats.memoryBudgetValid)
+    {
+        std::snprintf(text, sizeof(text), "VRAM %llu / %llu MB", static_cast<unsigned long long>(usage >> 20), static_cast<unsigned long long>(budget >> 20));
+    }
+    else
+    {
+        std::snprintf(text, sizeof(text), "VRAM N/A / %llu MB", static_cast<unsigned long long>(budget >> 20));
+    }
+    layout.text(left, y, text, hudTextColor);
+    y += line;
+    std::snprintf(text, sizeof(text), "HOST %.1f MB LIVE", stats.hostLiveBytes / (1024.0 * 1024.0));
+    layout.text(left, y, text, hudTextColor);
+    return layout.count;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "vulkan_init.h"
+
+#include <array>
+
+constexpr uint32_t hudGlyphPixels = 8;//atlas cell size, the glyphs themselves are 5x7
+constexpr uint32_t hudAtlasColumns = 16;//matches atlasCells in hud.vert
+constexpr uint32_t hudAtlasRows = 5;
+constexpr uint32_t hudFirstGlyph = 0x20;//the atlas holds ' ' to '_', lower case is drawn as upper
+constexpr uint32_t hudSolidGlyph = 0x60 - hudFirstGlyph;//the cell after '_' is filled in, for bars and panels
+constexpr uint32_t hudQuadCapacity = 1024;//per swapchain image
+constexpr uint32_t hudHistoryFrames = 120;//frame times in the graph
+
+//one instance of the hud's single draw, a glyph or a solid bar. matches the inputs of hud.vert.
+struct hud_quad
+{
+    float rect[4];//left, top, width and height in normalised device coordinates
+    uint32_t glyph;//atlas cell
+    uint32_t color;//rgba8, red in the low byte
+};
+
+//the glyph atlas and the descriptor set sampling it, shared by every target's hud
+struct hud_atlas
+{
+    VkImage image = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkImageView view = VK_NULL_HANDLE;
+    VkSampler sampler = VK_NULL_HANDLE;
+    VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+};
+
+//the cpu side of recent frames. gathered every frame whether or not a hud is drawing them, so
+//turning it on doesn't change what is measured.
+struct frame_timings
+{
+    std::array<float, hudHistoryFrames> frameMilliseconds{};//wall clock between frames, oldest overwritten first
+    uint64_t frameCount = 0;
+
+    //phases of the latest frame, each timed on its own so the hud's writes fall in none of them
+    double waitMilliseconds = 0.0;//on the frame's fence
+    double acquireMilliseconds = 0.0;//swapchain images and their fences
+    double cullMilliseconds = 0.0;
+    double recordMilliseconds = 0.0;
+    double submitMilliseconds = 0.0;//and present
+    double hudMilliseconds = 0.0;//writing the huds themselves
+
+    bool computeValid = false;//particle step on the compute queue
+    double computeMilliseconds = 0.0;
+};
+
+void pushFrameTime(frame_timings& timings, float const milliseconds);
+
+//uploads the atlas on graphicsQueue and waits for it, commandPool must belong to its family
+void createHudAtlas(hud_atlas& atlas,
+    VkPhysicalDevice const& physicalDevice,
+    VkDevice const& logicalDevice,
+    VkQueue const& graphicsQueue,
+    VkCommandPool const& commandPool,
+    host_allocator& hostAllocator);
+
+void destroyHudAtlas(hud_atlas& atlas, VkDevice const& logicalDevice, host_allocator& hostAllocator);
+
+//instanced triangle strips over the whole image, blended on top of it
+graphics_pipeline_description hudPipelineDescription(hud_atlas const& atlas);
+
+//lays out the panel for one target into at most capacity quads and returns how many it wrote.
+//scale is screen pixels per atlas pixel. nothing here allocates.
+uint32_t writeHudQuads(hud_quad* quads,
+    uint32_t const capacity,
+    VkExtent2D const& extent,
+    uint32_t const scale,
+    frame_stats const& stats,
+    frame_timings const& timings);
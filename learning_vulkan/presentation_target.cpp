@@ -0,0 +1,446 @@
+#include "presentation_target.h"
+#include <cstddef>
+#include <string>
+
+namespace
+{
+    graphics_pipeline_description instancePipelineDescription()
+    {
+        graphics_pipeline_description reply;
+        reply.vertexShader = "shaders/instanced_vert.spv";
+        //instances are tumbling, both faces have to show
+        reply.cullMode = VK_CULL_MODE_NONE;
+
+        VkVertexInputBindingDescription binding{};
+        binding.binding = 0;
+        binding.stride = sizeof(instance_gpu_data);
+        binding.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+        reply.vertexBindings.push_back(binding);
+
+        //a mat4 attribute takes one location per column
+        for(uint32_t column = 0; column < 4; ++column)
+        {
+            reply.vertexAttributes.push_back({ column, 0, VK_FORMAT_R32G32B32A32_SFLOAT, static_cast<uint32_t>(offsetof(instance_gpu_data, transform) + column * 4 * sizeof(float)) });
+        }
+        reply.vertexAttributes.push_back({ 4, 0, VK_FORMAT_R32G32B32A32_SFLOAT, static_cast<uint32_t>(offsetof(instance_gpu_data, color)) });
+        return reply;
+    }
+
+    //rendering offscreen and blitting needs the swapchain to take transfers and the format to filter
+    bool upscaleSupported(VkPhysicalDevice const& physicalDevice, swap_chain_support_details const& swapChainSupport, VkFormat const format)
+    {
+        VkFormatProperties properties;
+        vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &properties);
+        VkFormatFeatureFlags const required = VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT
+            | VK_FORMAT_FEATURE_BLIT_SRC_BIT
+            | VK_FORMAT_FEATURE_BLIT_DST_BIT
+            | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+        return (swapChainSupport.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT)
+            && (properties.optimalTilingFeatures & required) == required;
+    }
+}
+
+GLFWwindow* createPresentationWindow(uint32_t const targetIndex)
+{
+    std::string const title = "Vulkan Window " + std::to_string(targetIndex);
+    GLFWwindow* reply = glfwCreateWindow(windowWidth, windowHeight, title.c_str(), nullptr, nullptr);
+    if(!reply)
+    {
+        throw std::runtime_error("Failed to create window " + std::to_string(targetIndex) + '.');
+    }
+    //cascade the windows so they don't all open on top of each other
+    int const offset = 64 + 48 * static_cast<int>(targetIndex);
+    glfwSetWindowPos(reply, offset, offset);
+    return reply;
+}
+
+void createSwapChainResources(presentation_target& target,
+    VkPhysicalDevice const& physicalDevice,
+    VkDevice const& logicalDevice,
+    VkCommandPool const& commandPool,
+    VkPhysicalDeviceFeatures const& enabledFeatures,
+    streamed_mesh const* mesh,
+    uint32_t const meshCopyCount,
+    uint32_t const instanceCapacity,
+    particle_system const* particles,
+    hud_atlas const* hud,
+    bool const dynamicResolution,
+    host_allocator& hostAllocator)
+{
+    swap_chain_support_details swapChainSupport = querySwapChainSupport(physicalDevice, target.surface);
+    if(swapChainSupport.formats.empty() || swapChainSupport.presentModes.empty())
+    {
+        throw std::runtime_error("A presentation surface has no usable swap chain formats.");
+    }
+    target.swapChain = createSwapChain(swapChainSupport, target.surface, physicalDevice, logicalDevice, hostAllocator);
+    uint32_t imageCount;
+    vkGetSwapchainImagesKHR(logicalDevice, target.swapChain, &imageCount, nullptr);
+    target.swapChainImages.resize(imageCount);
+    vkGetSwapchainImagesKHR(logicalDevice, target.swapChain, &imageCount, target.swapChainImages.data());
+    target.swapChainImageFormat = chooseSwapSurfaceFormat(swapChainSupport.formats).format;
+    target.swapChainExtent = chooseSwapExtent(swapChainSupport.capabilities);
+    target.swapChainImageViews = createImageViews(target.swapChainImages, target.swapChainImageFormat, logicalDevice, hostAllocator);
+
+    bool const scaled = dynamicResolution && upscaleSupported(physicalDevice, swapChainSupport, target.swapChainImageFormat);
+    if(dynamicResolution && !scaled)
+    {
+        std::cerr << "Dynamic resolution is not supported for this surface, rendering at full size.\n";
+    }
+    target.resolutionLevels = scaled ? resolutionLevelCount : 1;
+    target.imageResolutionLevel.assign(imageCount, target.resolution.level());
+
+    //surfaces can disagree on format and extent so each target gets its own pass and pipeline
+    target.renderPass = createRenderPass(logicalDevice, target.swapChainImageFormat, scaled ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, hostAllocator);
+    graphics_pipeline_description triangleDescription;
+    triangleDescription.dynamicViewport = scaled;
+    auto const[graphicsPipelineResult, pipelineLayoutResult] = createGraphicsPipeline(logicalDevice, target.swapChainExtent, target.renderPass, VK_NULL_HANDLE, triangleDescription, hostAllocator);
+    target.graphicsPipeline = graphicsPipelineResult;
+    target.pipelineLayout = pipelineLayoutResult;
+
+    //everything is opaque and centred on the origin for now, so the keys only group by state
+    draw_state_ids stateIds;
+    vector<draw_item> draws;
+    if(mesh)
+    {
+        graphics_pipeline_description meshDescription = meshPipelineDescription();
+        meshDescription.dynamicViewport = scaled;
+        std::tie(target.meshPipeline, target.meshPipelineLayout) = createGraphicsPipeline(logicalDevice, target.swapChainExtent, target.renderPass, VK_NULL_HANDLE, meshDescription, hostAllocator);
+
+        //every copy could land on any level, so each level has room for all of them
+        uint32_t const lodCount = mesh->header.lodCount;
+        target.meshCopyCount = meshCopyCount;
+        VkDeviceSize const lodBytes = sizeof(float4x4) * meshCopyCount;
+        VkDeviceSize const instanceBytes = lodBytes * lodCount * imageCount;
+        std::tie(target.meshInstanceBuffer, target.meshInstanceMemory) = createBuffer(physicalDevice,
+            logicalDevice,
+            instanceBytes,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            hostAllocator);
+        void* instanceMapping;
+        vkMapMemory(logicalDevice, target.meshInstanceMemory, 0, instanceBytes, 0, &instanceMapping);
+        target.meshInstances = static_cast<float4x4*>(instanceMapping);
+
+        VkDeviceSize const indirectSize = sizeof(VkDrawIndexedIndirectCommand) * lodCount * imageCount;
+        std::tie(target.indirectBuffer, target.indirectMemory) = createBuffer(physicalDevice,
+            logicalDevice,
+            indirectSize,
+            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            hostAllocator);
+        void* indirectMapping;
+        vkMapMemory(logicalDevice, target.indirectMemory, 0, indirectSize, 0, &indirectMapping);
+        target.indirectCommands = static_cast<VkDrawIndexedIndirectCommand*>(indirectMapping);
+        for(uint32_t i = 0; i < lodCount * imageCount; ++i)
+        {
+            target.indirectCommands[i] = { 0, 0, 0, 0, 0 };
+        }
+
+        //a draw per level, instancing whichever copies picked it this frame. they differ only in
+        //the instance range, so the pipeline, vertices and indices are bound once for all of them.
+        for(uint32_t lod = 0; lod < lodCount; ++lod)
+        {
+            draw_command meshDraw;
+            meshDraw.pipeline = target.meshPipeline;
+            meshDraw.vertexBuffer = mesh->vertexBuffer;
+            meshDraw.instanceBuffer = target.meshInstanceBuffer;
+            meshDraw.instanceSliceBytes = lodBytes * lodCount;
+            meshDraw.instanceOffset = lodBytes * lod;
+            meshDraw.indexBuffer = mesh->indexBuffer;
+            meshDraw.indirectBuffer = target.indirectBuffer;
+            meshDraw.indirectOffset = sizeof(VkDrawIndexedIndirectCommand) * imageCount * lod;
+            draws.push_back(makeDrawItem(meshDraw, draw_pass::opaque, 0.0f, stateIds));
+        }
+    }
+
+    if(instanceCapacity > 0)
+    {
+        graphics_pipeline_description instanceDescription = instancePipelineDescription();
+        instanceDescription.dynamicViewport = scaled;
+        std::tie(target.instancePipeline, target.instancePipelineLayout) = createGraphicsPipeline(logicalDevice, target.swapChainExtent, target.renderPass, VK_NULL_HANDLE, instanceDescription, hostAllocator);
+
+        //the culling kernels write straight into this mapping, so every image needs room for the whole scene
+        target.instanceCapacity = instanceCapacity;
+        VkDeviceSize const sliceBytes = sizeof(instance_gpu_data) * instanceCapacity;
+        std::tie(target.instanceBuffer, target.instanceMemory) = createBuffer(physicalDevice,
+            logicalDevice,
+            sliceBytes * imageCount,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            hostAllocator);
+        void* instanceMapping;
+        vkMapMemory(logicalDevice, target.instanceMemory, 0, sliceBytes * imageCount, 0, &instanceMapping);
+        target.instanceData = static_cast<instance_gpu_data*>(instanceMapping);
+
+        VkDeviceSize const indirectSize = sizeof(VkDrawIndirectCommand) * imageCount;
+        std::tie(target.instanceIndirectBuffer, target.instanceIndirectMemory) = createBuffer(physicalDevice,
+            logicalDevice,
+            indirectSize,
+            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            hostAllocator);
+        void* indirectMapping;
+        vkMapMemory(logicalDevice, target.instanceIndirectMemory, 0, indirectSize, 0, &indirectMapping);
+        target.instanceIndirectCommands = static_cast<VkDrawIndirectCommand*>(indirectMapping);
+        for(uint32_t i = 0; i < imageCount; ++i)
+        {
+            target.instanceIndirectCommands[i] = { 3, 0, 0, 0 };
+        }
+
+        //counts are filled in by the cpu for the frame this image shows, i.e. what survived culling
+        draw_command instanceDraw;
+        instanceDraw.pipeline = target.instancePipeline;
+        instanceDraw.vertexBuffer = target.instanceBuffer;
+        instanceDraw.sliceBytes = sliceBytes;
+        instanceDraw.indirectBuffer = target.instanceIndirectBuffer;
+        draws.push_back(makeDrawItem(instanceDraw, draw_pass::opaque, 0.0f, stateIds));
+    }
+
+    if(particles != nullptr)
+    {
+        graphics_pipeline_description particleDescription = particlePipelineDescription();
+        particleDescription.dynamicViewport = scaled;
+        std::tie(target.particlePipeline, target.particlePipelineLayout) = createGraphicsPipeline(logicalDevice, target.swapChainExtent, target.renderPass, VK_NULL_HANDLE, particleDescription, hostAllocator);
+
+        //both halves stay bound, firstVertex picks the one the latest step wrote
+        VkDeviceSize const indirectSize = sizeof(VkDrawIndirectCommand) * imageCount;
+        std::tie(target.particleIndirectBuffer, target.particleIndirectMemory) = createBuffer(physicalDevice,
+            logicalDevice,
+            indirectSize,
+            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            hostAllocator);
+        void* indirectMapping;
+        vkMapMemory(logicalDevice, target.particleIndirectMemory, 0, indirectSize, 0, &indirectMapping);
+        target.particleIndirectCommands = static_cast<VkDrawIndirectCommand*>(indirectMapping);
+        for(uint32_t i = 0; i < imageCount; ++i)
+        {
+            target.particleIndirectCommands[i] = { 0, 1, 0, 0 };
+        }
+
+        draw_command particleDraw;
+        particleDraw.pipeline = target.particlePipeline;
+        particleDraw.vertexBuffer = particles->particleBuffer;
+        particleDraw.indirectBuffer = target.particleIndirectBuffer;
+        draws.push_back(makeDrawItem(particleDraw, draw_pass::opaque, 0.0f, stateIds));
+    }
+
+    if(scaled)
+    {
+        //full size so every level fits, a level only draws into its top left corner
+        for(uint32_t i = 0; i < imageCount; ++i)
+        {
+            auto const[image, memory] = createImage(physicalDevice,
+                logicalDevice,
+                target.swapChainExtent,
+                1,
+                target.swapChainImageFormat,
+                VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                hostAllocator);
+            target.offscreenImages.push_back(image);
+            target.offscreenMemory.push_back(memory);
+        }
+        target.offscreenImageViews = createImageViews(target.offscreenImages, target.swapChainImageFormat, logicalDevice, hostAllocator);
+    }
+    target.swapChainFramebuffers = createFreamebuffers(logicalDevice, scaled ? target.offscreenImageViews : target.swapChainImageViews, target.renderPass, target.swapChainExtent, hostAllocator);
+
+    if(hud != nullptr)
+    {
+        //after the scene's queries, timestamps and upscale, so the hud is drawn at full resolution
+        //and never counted in what it shows
+        target.hudRenderPass = createRenderPass(logicalDevice, target.swapChainImageFormat, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, hostAllocator, VK_ATTACHMENT_LOAD_OP_LOAD);
+        target.hudFramebuffers = createFreamebuffers(logicalDevice, target.swapChainImageViews, target.hudRenderPass, target.swapChainExtent, hostAllocator);
+        std::tie(target.hudPipeline, target.hudPipelineLayout) = createGraphicsPipeline(logicalDevice, target.swapChainExtent, target.hudRenderPass, VK_NULL_HANDLE, hudPipelineDescription(*hud), hostAllocator);
+
+        VkDeviceSize const sliceBytes = sizeof(hud_quad) * hudQuadCapacity;
+        std::tie(target.hudQuadBuffer, target.hudQuadMemory) = createBuffer(physicalDevice,
+            logicalDevice,
+            sliceBytes * imageCount,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            hostAllocator);
+        void* quadMapping;
+        vkMapMemory(logicalDevice, target.hudQuadMemory, 0, sliceBytes * imageCount, 0, &quadMapping);
+        target.hudQuads = static_cast<hud_quad*>(quadMapping);
+
+        VkDeviceSize const indirectSize = sizeof(VkDrawIndirectCommand) * imageCount;
+        std::tie(target.hudIndirectBuffer, target.hudIndirectMemory) = createBuffer(physicalDevice,
+            logicalDevice,
+            indirectSize,
+            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            hostAllocator);
+        void* indirectMapping;
+        vkMapMemory(logicalDevice, target.hudIndirectMemory, 0, indirectSize, 0, &indirectMapping);
+        target.hudIndirectCommands = static_cast<VkDrawIndirectCommand*>(indirectMapping);
+        for(uint32_t i = 0; i < imageCount; ++i)
+        {
+            target.hudIndirectCommands[i] = { 4, 0, 0, 0 };
+        }
+    }
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    float const timestampPeriod = properties.limits.timestampComputeAndGraphics ? properties.limits.timestampPeriod : 0.0f;
+    target.statsPools = createStatsQueryPools(logicalDevice, imageCount, enabledFeatures, timestampPeriod, hostAllocator);
+    chunked_frame_layout layout;
+    layout.renderPass = target.renderPass;
+    layout.framebuffers = target.swapChainFramebuffers;
+    layout.extent = target.swapChainExtent;
+    layout.levelCount = target.resolutionLevels;
+    layout.upscale.sourceImages = target.offscreenImages;
+    layout.upscale.destinationImages = target.swapChainImages;
+    layout.statsPools = target.statsPools;
+    layout.overlayRenderPass = target.hudRenderPass;
+    layout.overlayFramebuffers = target.hudFramebuffers;
+    target.chunks.create(logicalDevice, commandPool, layout);
+    if(draws.empty())
+    {
+        draw_command triangleDraw;
+        triangleDraw.pipeline = target.graphicsPipeline;
+        triangleDraw.vertexCount = 3;
+        draws.push_back(makeDrawItem(triangleDraw, draw_pass::opaque, 0.0f, stateIds));
+    }
+    target.chunks.add(draws);
+    if(hud != nullptr)
+    {
+        //every glyph and bar is one instance of a single draw, the quad count is filled in each frame
+        draw_command hudDraw;
+        hudDraw.pipeline = target.hudPipeline;
+        hudDraw.pipelineLayout = target.hudPipelineLayout;
+        hudDraw.descriptorSet = hud->descriptorSet;
+        hudDraw.vertexBuffer = target.hudQuadBuffer;
+        hudDraw.sliceBytes = sizeof(hud_quad) * hudQuadCapacity;
+        hudDraw.indirectBuffer = target.hudIndirectBuffer;
+        target.hudChunk = target.chunks.add({ makeDrawItem(hudDraw, draw_pass::overlay, 0.0f, stateIds) }, true);
+    }
+
+    target.imagesInFlight.assign(imageCount, VK_NULL_HANDLE);
+    target.imageSubmittedFrame.assign(imageCount, 0);
+}
+
+void destroySwapChainResources(presentation_target& target, VkDevice const& logicalDevice, host_allocator& hostAllocator)
+{
+    target.chunks.destroy();
+    destroyStatsQueryPools(logicalDevice, target.statsPools, hostAllocator);
+    for(VkFramebuffer const& framebuffer : target.swapChainFramebuffers)
+    {
+        vkDestroyFramebuffer(logicalDevice, framebuffer, hostAllocator.callbacks(VK_OBJECT_TYPE_FRAMEBUFFER));
+    }
+    if(target.meshPipeline != VK_NULL_HANDLE)
+    {
+        vkUnmapMemory(logicalDevice, target.meshInstanceMemory);
+        vkDestroyBuffer(logicalDevice, target.meshInstanceBuffer, hostAllocator.callbacks(VK_OBJECT_TYPE_BUFFER));
+        vkFreeMemory(logicalDevice, target.meshInstanceMemory, hostAllocator.callbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+        vkUnmapMemory(logicalDevice, target.indirectMemory);
+        vkDestroyBuffer(logicalDevice, target.indirectBuffer, hostAllocator.callbacks(VK_OBJECT_TYPE_BUFFER));
+        vkFreeMemory(logicalDevice, target.indirectMemory, hostAllocator.callbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+        vkDestroyPipeline(logicalDevice, target.meshPipeline, hostAllocator.callbacks(VK_OBJECT_TYPE_PIPELINE));
+        vkDestroyPipelineLayout(logicalDevice, target.meshPipelineLayout, hostAllocator.callbacks(VK_OBJECT_TYPE_PIPELINE_LAYOUT));
+        target.meshPipeline = VK_NULL_HANDLE;
+        target.meshInstances = nullptr;
+        target.indirectCommands = nullptr;
+    }
+    if(target.instancePipeline != VK_NULL_HANDLE)
+    {
+        vkUnmapMemory(logicalDevice, target.instanceMemory);
+        vkDestroyBuffer(logicalDevice, target.instanceBuffer, hostAllocator.callbacks(VK_OBJECT_TYPE_BUFFER));
+        vkFreeMemory(logicalDevice, target.instanceMemory, hostAllocator.callbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+        vkUnmapMemory(logicalDevice, target.instanceIndirectMemory);
+        vkDestroyBuffer(logicalDevice, target.instanceIndirectBuffer, hostAllocator.callbacks(VK_OBJECT_TYPE_BUFFER));
+        vkFreeMemory(logicalDevice, target.instanceIndirectMemory, hostAllocator.callbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+        vkDestroyPipeline(logicalDevice, target.instancePipeline, hostAllocator.callbacks(VK_OBJECT_TYPE_PIPELINE));
+        vkDestroyPipelineLayout(logicalDevice, target.instancePipelineLayout, hostAllocator.callbacks(VK_OBJECT_TYPE_PIPELINE_LAYOUT));
+        target.instancePipeline = VK_NULL_HANDLE;
+        target.instanceData = nullptr;
+        target.instanceIndirectCommands = nullptr;
+    }
+    if(target.hudPipeline != VK_NULL_HANDLE)
+    {
+        for(VkFramebuffer const& framebuffer : target.hudFramebuffers)
+        {
+            vkDestroyFramebuffer(logicalDevice, framebuffer, hostAllocator.callbacks(VK_OBJECT_TYPE_FRAMEBUFFER));
+        }
+        vkUnmapMemory(logicalDevice, target.hudQuadMemory);
+        vkDestroyBuffer(logicalDevice, target.hudQuadBuffer, hostAllocator.callbacks(VK_OBJECT_TYPE_BUFFER));
+        vkFreeMemory(logicalDevice, target.hudQuadMemory, hostAllocator.callbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+        vkUnmapMemory(logicalDevice, target.hudIndirectMemory);
+        vkDestroyBuffer(logicalDevice, target.hudIndirectBuffer, hostAllocator.callbacks(VK_OBJECT_TYPE_BUFFER));
+        vkFreeMemory(logicalDevice, target.hudIndirectMemory, hostAllocator.callbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+        vkDestroyPipeline(logicalDevice, target.hudPipeline, hostAllocator.callbacks(VK_OBJECT_TYPE_PIPELINE));
+        vkDestroyPipelineLayout(logicalDevice, target.hudPipelineLayout, hostAllocator.callbacks(VK_OBJECT_TYPE_PIPELINE_LAYOUT));
+        vkDestroyRenderPass(logicalDevice, target.hudRenderPass, hostAllocator.callbacks(VK_OBJECT_TYPE_RENDER_PASS));
+        target.hudPipeline = VK_NULL_HANDLE;
+        target.hudQuads = nullptr;
+        target.hudIndirectCommands = nullptr;
+        target.hudFramebuffers.clear();
+    }
+    if(target.particlePipeline != VK_NULL_HANDLE)
+    {
+        vkUnmapMemory(logicalDevice, target.particleIndirectMemory);
+        vkDestroyBuffer(logicalDevice, target.particleIndirectBuffer, hostAllocator.callbacks(VK_OBJECT_TYPE_BUFFER));
+        vkFreeMemory(logicalDevice, target.particleIndirectMemory, hostAllocator.callbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+        vkDestroyPipeline(logicalDevice, target.particlePipeline, hostAllocator.callbacks(VK_OBJECT_TYPE_PIPELINE));
+        vkDestroyPipelineLayout(logicalDevice, target.particlePipelineLayout, hostAllocator.callbacks(VK_OBJECT_TYPE_PIPELINE_LAYOUT));
+        target.particlePipeline = VK_NULL_HANDLE;
+        target.particleIndirectCommands = nullptr;
+    }
+    vkDestroyPipeline(logicalDevice, target.graphicsPipeline, hostAllocator.callbacks(VK_OBJECT_TYPE_PIPELINE));
+    vkDestroyPipelineLayout(logicalDevice, target.pipelineLayout, hostAllocator.callbacks(VK_OBJECT_TYPE_PIPELINE_LAYOUT));
+    vkDestroyRenderPass(logicalDevice, target.renderPass, hostAllocator.callbacks(VK_OBJECT_TYPE_RENDER_PASS));
+    for(VkImageView const& imageView : target.swapChainImageViews)
+    {
+        vkDestroyImageView(logicalDevice, imageView, hostAllocator.callbacks(VK_OBJECT_TYPE_IMAGE_VIEW));
+    }
+    for(VkImageView const& imageView : target.offscreenImageViews)
+    {
+        vkDestroyImageView(logicalDevice, imageView, hostAllocator.callbacks(VK_OBJECT_TYPE_IMAGE_VIEW));
+    }
+    for(VkImage const& image : target.offscreenImages)
+    {
+        vkDestroyImage(logicalDevice, image, hostAllocator.callbacks(VK_OBJECT_TYPE_IMAGE));
+    }
+    for(VkDeviceMemory const& memory : target.offscreenMemory)
+    {
+        vkFreeMemory(logicalDevice, memory, hostAllocator.callbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+    }
+    vkDestroySwapchainKHR(logicalDevice, target.swapChain, hostAllocator.callbacks(VK_OBJECT_TYPE_SWAPCHAIN_KHR));
+
+    target.swapChainFramebuffers.clear();
+    target.swapChainImageViews.clear();
+    target.swapChainImages.clear();
+    target.offscreenImageViews.clear();
+    target.offscreenImages.clear();
+    target.offscreenMemory.clear();
+}
+
+VkCommandBuffer frameCommandBuffer(presentation_target& target, uint32_t const imageIndex)
+{
+    uint32_t const level = target.resolutionLevels > 1 ? target.resolution.level() : 0;
+    return target.chunks.prepare(imageIndex, level, target.latestStats);
+}
+
+void createTargetSemaphores(presentation_target& target, VkDevice const& logicalDevice, host_allocator& hostAllocator)
+{
+    target.imageAvailableSemaphores.resize(maxFramesInFlight);
+
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    for(VkSemaphore& semaphore : target.imageAvailableSemaphores)
+    {
+        if(VK_FAILED(vkCreateSemaphore(logicalDevice, &semaphoreInfo, hostAllocator.callbacks(VK_OBJECT_TYPE_SEMAPHORE), &semaphore)))
+        {
+            throw std::runtime_error("Failed to create semaphores.");
+        }
+    }
+}
+
+void destroyTargetSemaphores(presentation_target& target, VkDevice const& logicalDevice, host_allocator& hostAllocator)
+{
+    for(VkSemaphore const& semaphore : target.imageAvailableSemaphores)
+    {
+        vkDestroySemaphore(logicalDevice, semaphore, hostAllocator.callbacks(VK_OBJECT_TYPE_SEMAPHORE));
+    }
+    target.imageAvailableSemaphores.clear();
+}
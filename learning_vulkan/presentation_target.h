@@ -0,0 +1,109 @@
+#pragma once
+
+#include "command_chunks.h"
+#include "dynamic_resolution.h"
+#include "instance_culling.h"
+#include "mesh_lod.h"
+#include "mesh_stream.h"
+#include "particle_system.h"
+#include "performance_hud.h"
+#include "vulkan_init.h"
+
+//one output view: a window and everything hanging off its swapchain. the device, queues and
+//command pool are shared between all of them.
+struct presentation_target
+{
+    GLFWwindow* window = nullptr;
+    VkSurfaceKHR surface = VK_NULL_HANDLE;
+
+    VkSwapchainKHR swapChain = VK_NULL_HANDLE;
+    image_list swapChainImages;
+    VkFormat swapChainImageFormat;
+    VkExtent2D swapChainExtent;
+    image_views swapChainImageViews;
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    VkPipeline graphicsPipeline = VK_NULL_HANDLE;
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    VkPipeline meshPipeline = VK_NULL_HANDLE;//only when a mesh is being streamed
+    VkPipelineLayout meshPipelineLayout = VK_NULL_HANDLE;
+    uint32_t meshCopyCount = 0;
+    VkBuffer meshInstanceBuffer = VK_NULL_HANDLE;//meshCopyCount transforms per level of detail, per swapchain image
+    VkDeviceMemory meshInstanceMemory = VK_NULL_HANDLE;
+    float4x4* meshInstances = nullptr;
+    VkBuffer indirectBuffer = VK_NULL_HANDLE;//a draw command per swapchain image for each level of detail in turn
+    VkDeviceMemory indirectMemory = VK_NULL_HANDLE;
+    VkDrawIndexedIndirectCommand* indirectCommands = nullptr;
+    VkPipeline instancePipeline = VK_NULL_HANDLE;//only when instances are being culled
+    VkPipelineLayout instancePipelineLayout = VK_NULL_HANDLE;
+    uint32_t instanceCapacity = 0;
+    VkBuffer instanceBuffer = VK_NULL_HANDLE;//instanceCapacity instances per swapchain image
+    VkDeviceMemory instanceMemory = VK_NULL_HANDLE;
+    instance_gpu_data* instanceData = nullptr;
+    VkBuffer instanceIndirectBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory instanceIndirectMemory = VK_NULL_HANDLE;
+    VkDrawIndirectCommand* instanceIndirectCommands = nullptr;
+    VkPipeline particlePipeline = VK_NULL_HANDLE;//only when particles are being simulated
+    VkPipelineLayout particlePipelineLayout = VK_NULL_HANDLE;
+    VkBuffer particleIndirectBuffer = VK_NULL_HANDLE;//a draw command per swapchain image
+    VkDeviceMemory particleIndirectMemory = VK_NULL_HANDLE;
+    VkDrawIndirectCommand* particleIndirectCommands = nullptr;
+    vector<VkFramebuffer> swapChainFramebuffers;//over the offscreen images when scaling resolution
+
+    //only when there is a hud. it draws over the finished image in a pass of its own.
+    VkRenderPass hudRenderPass = VK_NULL_HANDLE;
+    vector<VkFramebuffer> hudFramebuffers;
+    VkPipeline hudPipeline = VK_NULL_HANDLE;
+    VkPipelineLayout hudPipelineLayout = VK_NULL_HANDLE;
+    VkBuffer hudQuadBuffer = VK_NULL_HANDLE;//hudQuadCapacity quads per swapchain image
+    VkDeviceMemory hudQuadMemory = VK_NULL_HANDLE;
+    hud_quad* hudQuads = nullptr;
+    VkBuffer hudIndirectBuffer = VK_NULL_HANDLE;//a draw command per swapchain image
+    VkDeviceMemory hudIndirectMemory = VK_NULL_HANDLE;
+    VkDrawIndirectCommand* hudIndirectCommands = nullptr;
+    uint32_t hudChunk = 0;
+
+    //with dynamic resolution the scene is drawn into part of a full size offscreen image per
+    //swapchain image and blitted across. there is a set of command buffers per level.
+    uint32_t resolutionLevels = 1;
+    image_list offscreenImages;
+    vector<VkDeviceMemory> offscreenMemory;
+    image_views offscreenImageViews;
+    resolution_controller resolution;
+    vector<uint32_t> imageResolutionLevel;//what each image was last drawn at
+
+    command_chunks chunks;//the draws above in one chunk, or the triangle when there are none, then the hud
+    gpu_stats_pools statsPools;
+
+    vector<VkSemaphore> imageAvailableSemaphores;//one per frame in flight
+    vector<VkFence> imagesInFlight;
+    vector<uint64_t> imageSubmittedFrame;
+    uint32_t acquiredImage = 0;
+    frame_stats latestStats;
+};
+
+GLFWwindow* createPresentationWindow(uint32_t const targetIndex);
+
+//everything from the swapchain down to the chunks to record, commandPool must allow resetting
+//individual command buffers
+void createSwapChainResources(presentation_target& target,
+    VkPhysicalDevice const& physicalDevice,
+    VkDevice const& logicalDevice,
+    VkCommandPool const& commandPool,
+    VkPhysicalDeviceFeatures const& enabledFeatures,
+    streamed_mesh const* mesh,
+    uint32_t const meshCopyCount,
+    uint32_t const instanceCapacity,
+    particle_system const* particles,
+    hud_atlas const* hud,
+    bool const dynamicResolution,
+    host_allocator& hostAllocator);
+
+//the command buffer for imageIndex at the target's current resolution level, bringing whatever
+//changed since the image was last drawn up to date. the image's last submission must have retired.
+VkCommandBuffer frameCommandBuffer(presentation_target& target, uint32_t const imageIndex);
+
+void destroySwapChainResources(presentation_target& target, VkDevice const& logicalDevice, host_allocator& hostAllocator);
+
+void createTargetSemaphores(presentation_target& target, VkDevice const& logicalDevice, host_allocator& hostAllocator);
+
+void destroyTargetSemaphores(presentation_target& target, VkDevice const& logicalDevice, host_allocator& hostAllocator);
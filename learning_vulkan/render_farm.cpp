@@ -0,0 +1,296 @@
+#include "render_farm.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <thread>
+
+namespace
+{
+    //no surface to present to, so any device with a graphics queue will do
+    std::tuple<VkPhysicalDevice, queue_family_index_t, uint32_t> pickHeadlessDevice(VkInstance const& vulkanInstance)
+    {
+        uint32_t deviceCount = 0;
+        vkEnumeratePhysicalDevices(vulkanInstance, &deviceCount, nullptr);
+        vector<VkPhysicalDevice> devices(deviceCount);
+        vkEnumeratePhysicalDevices(vulkanInstance, &deviceCount, devices.data());
+
+        for(VkPhysicalDevice const& device : devices)
+        {
+            uint32_t queueFamilyCount = 0;
+            vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
+            vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+            vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
+            for(VkQueueFamilyProperties const& queueFamily : queueFamilies)
+            {
+                if(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+                {
+                    return { device, static_cast<queue_family_index_t>(&queueFamily - &queueFamilies[0]), queueFamily.queueCount };
+                }
+            }
+        }
+        throw std::runtime_error("Failed to find a GPU with a graphics queue.");
+    }
+}
+
+render_farm::render_farm(uint32_t const contextCount, VkExtent2D const& extent)
+    : extent(extent)
+{
+    if(contextCount == 0)
+    {
+        throw std::runtime_error("A render farm needs at least one context.");
+    }
+    vulkanInstance = createInstance(hostAllocator, false);
+    uint32_t familyQueueCount;
+    std::tie(physicalDevice, graphicsFamily, familyQueueCount) = pickHeadlessDevice(vulkanInstance);
+
+    //a queue per context when the family has enough, otherwise contexts take turns on a shared one
+    uint32_t const queueCount = std::min(contextCount, familyQueueCount);
+    vector<float> const queuePriorities(queueCount, 1.0f);
+
+    VkDeviceQueueCreateInfo queueCreateInfo{};
+    queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queueCreateInfo.queueFamilyIndex = graphicsFamily;
+    queueCreateInfo.queueCount = queueCount;
+    queueCreateInfo.pQueuePriorities = queuePriorities.data();
+
+    VkPhysicalDeviceFeatures const deviceFeatures{};
+    VkDeviceCreateInfo deviceCreateInfo{};
+    deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    deviceCreateInfo.pQueueCreateInfos = &queueCreateInfo;
+    deviceCreateInfo.queueCreateInfoCount = 1;
+    deviceCreateInfo.pEnabledFeatures = &deviceFeatures;
+
+    if(VK_FAILED(vkCreateDevice(physicalDevice, &deviceCreateInfo, hostAllocator.callbacks(VK_OBJECT_TYPE_DEVICE), &logicalDevice)))
+    {
+        throw std::runtime_error("Failed to create the render farm device.");
+    }
+    queues.resize(queueCount);
+    for(VkQueue& queue : queues)
+    {
+        vkGetDeviceQueue(logicalDevice, graphicsFamily, static_cast<uint32_t>(&queue - &queues[0]), &queue);
+    }
+    queueLocks = vector<std::mutex>(queueCount);
+
+    pipelineCache = createPipelineCache(logicalDevice, pipelineCacheFileName, hostAllocator);
+    renderPass = createRenderPass(logicalDevice, offscreenFormat, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, hostAllocator);
+    std::tie(graphicsPipeline, pipelineLayout) = createGraphicsPipeline(logicalDevice, extent, renderPass, pipelineCache, {}, hostAllocator);
+
+    contexts.resize(contextCount);
+    for(offscreen_render_context& context : contexts)
+    {
+        createContext(context, static_cast<uint32_t>(&context - &contexts[0]));
+    }
+}
+
+render_farm::~render_farm()
+{
+    vkDeviceWaitIdle(logicalDevice);
+    for(offscreen_render_context& context : contexts)
+    {
+        destroyContext(context);
+    }
+    savePipelineCache(logicalDevice, pipelineCache, pipelineCacheFileName);
+    vkDestroyPipeline(logicalDevice, graphicsPipeline, hostAllocator.callbacks(VK_OBJECT_TYPE_PIPELINE));
+    vkDestroyPipelineLayout(logicalDevice, pipelineLayout, hostAllocator.callbacks(VK_OBJECT_TYPE_PIPELINE_LAYOUT));
+    vkDestroyRenderPass(logicalDevice, renderPass, hostAllocator.callbacks(VK_OBJECT_TYPE_RENDER_PASS));
+    vkDestroyPipelineCache(logicalDevice, pipelineCache, hostAllocator.callbacks(VK_OBJECT_TYPE_PIPELINE_CACHE));
+    vkDestroyDevice(logicalDevice, hostAllocator.callbacks(VK_OBJECT_TYPE_DEVICE));
+    vkDestroyInstance(vulkanInstance, hostAllocator.callbacks(VK_OBJECT_TYPE_INSTANCE));
+}
+
+void render_farm::createContext(offscreen_render_context& context, uint32_t const contextIndex)
+{
+    uint32_t const queueIndex = contextIndex % queueCount();
+    context.queue = queues[queueIndex];
+    context.queueLock = &queueLocks[queueIndex];
+
+    context.commandPool = createCommandPool(logicalDevice, graphicsFamily, hostAllocator);
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = context.commandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
+    if(VK_FAILED(vkAllocateCommandBuffers(logicalDevice, &allocInfo, &context.commandBuffer)))
+    {
+        throw std::runtime_error("Failed to allocate a render farm command buffer.");
+    }
+
+    std::tie(context.image, context.imageMemory) = createImage(physicalDevice,
+        logicalDevice,
+        extent,
+        1,
+        offscreenFormat,
+        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+        hostAllocator);
+    context.imageView = createImageView(context.image, offscreenFormat, 1, logicalDevice, hostAllocator);
+    context.framebuffer = createFreamebuffers(logicalDevice, { context.imageView }, renderPass, extent, hostAllocator)[0];
+
+    VkDeviceSize const readbackSize = static_cast<VkDeviceSize>(extent.width) * extent.height * 4;
+    std::tie(context.readbackBuffer, context.readbackMemory) = createBuffer(physicalDevice,
+        logicalDevice,
+        readbackSize,
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        hostAllocator);
+    vkMapMemory(logicalDevice, context.readbackMemory, 0, readbackSize, 0, &context.readbackMapping);
+
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    if(VK_FAILED(vkCreateFence(logicalDevice, &fenceInfo, hostAllocator.callbacks(VK_OBJECT_TYPE_FENCE), &context.fence)))
+    {
+        throw std::runtime_error("Failed to create a render farm fence.");
+    }
+}
+
+void render_farm::destroyContext(offscreen_render_context& context)
+{
+    vkDestroyFence(logicalDevice, context.fence, hostAllocator.callbacks(VK_OBJECT_TYPE_FENCE));
+    vkUnmapMemory(logicalDevice, context.readbackMemory);
+    vkDestroyBuffer(logicalDevice, context.readbackBuffer, hostAllocator.callbacks(VK_OBJECT_TYPE_BUFFER));
+    vkFreeMemory(logicalDevice, context.readbackMemory, hostAllocator.callbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+    vkDestroyFramebuffer(logicalDevice, context.framebuffer, hostAllocator.callbacks(VK_OBJECT_TYPE_FRAMEBUFFER));
+    vkDestroyImageView(logicalDevice, context.imageView, hostAllocator.callbacks(VK_OBJECT_TYPE_IMAGE_VIEW));
+    vkDestroyImage(logicalDevice, context.image, hostAllocator.callbacks(VK_OBJECT_TYPE_IMAGE));
+    vkFreeMemory(logicalDevice, context.imageMemory, hostAllocator.callbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+    //frees the command buffer along with it
+    vkDestroyCommandPool(logicalDevice, context.commandPool, hostAllocator.callbacks(VK_OBJECT_TYPE_COMMAND_POOL));
+}
+
+vector<render_job_result> render_farm::run(vector<render_job> const& jobs)
+{
+    vector<render_job_result> results(jobs.size());
+    std::atomic<size_t> nextJob{ 0 };
+    vector<std::exception_ptr> failures(contexts.size());
+
+    auto const worker = [&](uint32_t const contextIndex)
+    {
+        try
+        {
+            for(size_t jobIndex = nextJob++; jobIndex < jobs.size(); jobIndex = nextJob++)
+            {
+                results[jobIndex].contextIndex = contextIndex;
+                renderJob(contexts[contextIndex], jobs[jobIndex], results[jobIndex]);
+            }
+        }
+        catch(...)
+        {
+            failures[contextIndex] = std::current_exception();
+            nextJob = jobs.size();//stop the other workers picking up anything new
+        }
+    };
+
+    uint32_t const workerCount = static_cast<uint32_t>(std::min(contexts.size(), jobs.size()));
+    vector<std::thread> workers;
+    workers.reserve(workerCount);
+    for(uint32_t contextIndex = 0; contextIndex < workerCount; ++contextIndex)
+    {
+        workers.emplace_back(worker, contextIndex);
+    }
+    for(std::thread& thread : workers)
+    {
+        thread.join();
+    }
+    for(std::exception_ptr const& failure : failures)
+    {
+        if(failure)
+        {
+            std::rethrow_exception(failure);
+        }
+    }
+    return results;
+}
+
+void render_farm::renderJob(offscreen_render_context& context, render_job const& job, render_job_result& result)
+{
+    auto const start = std::chrono::steady_clock::now();
+
+    //the pool only ever holds this one buffer so resetting it is the cheapest way to rerecord
+    vkResetCommandPool(logicalDevice, context.commandPool, 0);
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    if(VK_FAILED(vkBeginCommandBuffer(context.commandBuffer, &beginInfo)))
+    {
+        throw std::runtime_error("Failed to begin recording command buffer.");
+    }
+
+    VkRenderPassBeginInfo renderPassInfo{};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassInfo.renderPass = renderPass;
+    renderPassInfo.framebuffer = context.framebuffer;
+    renderPassInfo.renderArea.offset = { 0,0 };
+    renderPassInfo.renderArea.extent = extent;
+    VkClearValue clearColor{};
+    clearColor.color = job.clearColor;
+    renderPassInfo.clearValueCount = 1;
+    renderPassInfo.pClearValues = &clearColor;
+
+    vkCmdBeginRenderPass(context.commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdBindPipeline(context.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+    vkCmdDraw(context.commandBuffer, 3, 1, 0, 0);
+    vkCmdEndRenderPass(context.commandBuffer);
+
+    //the render pass ends in TRANSFER_SRC_OPTIMAL and its outgoing dependency orders the copy after its writes
+    VkBufferImageCopy copyRegion{};
+    copyRegion.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    copyRegion.imageExtent = { extent.width, extent.height, 1 };
+    vkCmdCopyImageToBuffer(context.commandBuffer, context.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, context.readbackBuffer, 1, &copyRegion);
+
+    VkBufferMemoryBarrier toHost{};
+    toHost.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    toHost.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    toHost.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    toHost.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toHost.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toHost.buffer = context.readbackBuffer;
+    toHost.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(context.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &toHost, 0, nullptr);
+
+    if(VK_FAILED(vkEndCommandBuffer(context.commandBuffer)))
+    {
+        throw std::runtime_error("Failed to record command buffer.");
+    }
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &context.commandBuffer;
+    for(uint32_t frame = 0; frame < std::max(job.frameCount, 1u); ++frame)
+    {
+        {
+            //queues are externally synchronised, the wait below happens without the lock held
+            std::lock_guard<std::mutex> const guard(*context.queueLock);
+            if(VK_FAILED(vkQueueSubmit(context.queue, 1, &submitInfo, context.fence)))
+            {
+                throw std::runtime_error("Failed to submit render farm job.");
+            }
+        }
+        vkWaitForFences(logicalDevice, 1, &context.fence, VK_TRUE, UINT64_MAX);
+        vkResetFences(logicalDevice, 1, &context.fence);
+    }
+
+    size_t const pixelBytes = static_cast<size_t>(extent.width) * extent.height * 4;
+    result.jobId = job.id;
+    result.pixels.resize(pixelBytes);
+    std::memcpy(result.pixels.data(), context.readbackMapping, pixelBytes);
+    if(!job.outputPath.empty())
+    {
+        writePpm(job.outputPath, result.pixels, extent);
+    }
+    result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void writePpm(std::string const& fileName, vector<uint8_t> const& rgbaPixels, VkExtent2D const& extent)
+{
+    std::ofstream file(fileName, std::ios::binary);
+    if(!file.is_open())
+    {
+        throw std::runtime_error("Failed to open " + fileName);
+    }
+    file << "P6\n" << extent.width << ' ' << extent.height << "\n255\n";
+    for(size_t pixel = 0; pixel < rgbaPixels.size(); pixel += 4)
+    {
+        file.write(reinterpret_cast<char const*>(&rgbaPixels[pixel]), 3);
+    }
+}
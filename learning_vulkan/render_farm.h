@@ -0,0 +1,86 @@
+#pragma once
+
+#include "vulkan_init.h"
+
+#include <mutex>
+#include <string>
+
+constexpr VkFormat offscreenFormat = VK_FORMAT_R8G8B8A8_UNORM;
+constexpr char const* pipelineCacheFileName = "pipeline_cache.bin";
+
+struct render_job
+{
+    uint32_t id = 0;
+    uint32_t frameCount = 1;//submissions before the image is read back
+    VkClearColorValue clearColor{};
+    std::string outputPath;//ppm, left empty to skip writing the image out
+};
+
+struct render_job_result
+{
+    uint32_t jobId = 0;
+    uint32_t contextIndex = 0;
+    double milliseconds = 0.0;
+    vector<uint8_t> pixels;//tightly packed rgba8
+};
+
+//everything one worker thread touches without taking a lock. the queue may be shared with
+//other contexts so submissions go through queueLock.
+struct offscreen_render_context
+{
+    VkQueue queue = VK_NULL_HANDLE;
+    std::mutex* queueLock = nullptr;
+
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    VkImage image = VK_NULL_HANDLE;
+    VkDeviceMemory imageMemory = VK_NULL_HANDLE;
+    VkImageView imageView = VK_NULL_HANDLE;
+    VkFramebuffer framebuffer = VK_NULL_HANDLE;
+    VkBuffer readbackBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory readbackMemory = VK_NULL_HANDLE;
+    void* readbackMapping = nullptr;
+    VkFence fence = VK_NULL_HANDLE;
+};
+
+//headless batch renderer: one device shared by a set of offscreen contexts, each driven by its
+//own worker thread. the render pass, pipeline and pipeline cache are created once and shared,
+//the cache is loaded from and saved back to pipelineCacheFileName.
+class render_farm
+{
+public:
+    render_farm(uint32_t const contextCount, VkExtent2D const& extent);
+    ~render_farm();
+
+    render_farm(render_farm const&) = delete;
+    render_farm& operator=(render_farm const&) = delete;
+
+    //blocks until every job is done, results come back in job order
+    vector<render_job_result> run(vector<render_job> const& jobs);
+
+    uint32_t contextCount() const { return static_cast<uint32_t>(contexts.size()); }
+    uint32_t queueCount() const { return static_cast<uint32_t>(queues.size()); }
+
+private:
+    void createContext(offscreen_render_context& context, uint32_t const contextIndex);
+    void destroyContext(offscreen_render_context& context);
+    void renderJob(offscreen_render_context& context, render_job const& job, render_job_result& result);
+
+    host_allocator hostAllocator;
+    VkInstance vulkanInstance = VK_NULL_HANDLE;
+    VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+    VkDevice logicalDevice = VK_NULL_HANDLE;
+    queue_family_index_t graphicsFamily = 0;
+    vector<VkQueue> queues;
+    vector<std::mutex> queueLocks;
+
+    VkExtent2D extent;
+    VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    VkPipeline graphicsPipeline = VK_NULL_HANDLE;
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+
+    vector<offscreen_render_context> contexts;
+};
+
+void writePpm(std::string const& fileName, vector<uint8_t> const& rgbaPixels, VkExtent2D const& extent);
@@ -1,3 +1,9 @@
 "%VULKAN_SDK%\Bin32\glslc.exe" shader.vert -o vert.spv
 "%VULKAN_SDK%\Bin32\glslc.exe" shader.frag -o frag.spv
+"%VULKAN_SDK%\Bin32\glslc.exe" mesh.vert -o mesh_vert.spv
+"%VULKAN_SDK%\Bin32\glslc.exe" instanced.vert -o instanced_vert.spv
+"%VULKAN_SDK%\Bin32\glslc.exe" particles.vert -o particles_vert.spv
+"%VULKAN_SDK%\Bin32\glslc.exe" particles.comp -o particles_comp.spv
+"%VULKAN_SDK%\Bin32\glslc.exe" hud.vert -o hud_vert.spv
+"%VULKAN_SDK%\Bin32\glslc.exe" hud.frag -o hud_frag.spv
 pause
\ No newline at end of file
@@ -0,0 +1,15 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(binding = 0) uniform sampler2D atlas;
+
+layout(location = 0) in vec2 fragUv;
+layout(location = 1) in vec4 fragColor;
+
+layout(location = 0) out vec4 outColor;
+
+void main()
+{
+    //the atlas is coverage only, the colour comes from the instance
+    outColor = vec4(fragColor.rgb, fragColor.a * texture(atlas, fragUv).r);
+}
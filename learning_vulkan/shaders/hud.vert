@@ -0,0 +1,23 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(location = 0) in vec4 inRect;
+layout(location = 1) in uint inGlyph;
+layout(location = 2) in vec4 inColor;
+
+layout(location = 0) out vec2 fragUv;
+layout(location = 1) out vec4 fragColor;
+
+//hudAtlasColumns by hudAtlasRows cells in performance_hud.h
+const uint atlasColumns = 16;
+const vec2 atlasCells = vec2(16.0, 5.0);
+
+void main()
+{
+    //each instance is a four vertex strip over its rect
+    vec2 corner = vec2(gl_VertexIndex & 1, gl_VertexIndex >> 1);
+    gl_Position = vec4(inRect.xy + corner * inRect.zw, 0.0, 1.0);
+    vec2 cell = vec2(inGlyph % atlasColumns, inGlyph / atlasColumns);
+    fragUv = (cell + corner) / atlasCells;
+    fragColor = inColor;
+}
@@ -0,0 +1,20 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+//the cpu culls and premultiplies each instance into clip space, so one attribute carries it all
+layout(location = 0) in mat4 instanceTransform;
+layout(location = 4) in vec4 instanceColor;
+
+layout(location = 0) out vec3 fragColor;
+
+vec2 positions[3] = vec2[](
+    vec2(0.0, -0.5),
+    vec2(0.5, 0.5),
+    vec2(-0.5, 0.5)
+);
+
+void main()
+{
+    gl_Position = instanceTransform * vec4(positions[gl_VertexIndex], 0.0, 1.0);
+    fragColor = instanceColor.rgb;
+}
@@ -0,0 +1,15 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+//one per copy of the mesh, the cpu has already taken it into clip space
+layout(location = 2) in mat4 instanceTransform;
+
+layout(location = 0) out vec3 fragColor;
+
+void main()
+{
+    gl_Position = instanceTransform * vec4(inPosition, 1.0);
+    fragColor = inColor;
+}
\ No newline at end of file
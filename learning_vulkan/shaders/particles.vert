@@ -0,0 +1,16 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(location = 0) in vec4 inPosition;
+layout(location = 1) in vec4 inVelocity;
+
+layout(location = 0) out vec3 fragColor;
+
+void main()
+{
+    gl_Position = vec4(inPosition.xy, 0.0, 1.0);
+    gl_PointSize = 1.0;
+    //slow particles are blue, fast ones red
+    float speed = clamp(length(inVelocity.xy) * 0.8, 0.0, 1.0);
+    fragColor = mix(vec3(0.2, 0.4, 1.0), vec3(1.0, 0.3, 0.1), speed);
+}
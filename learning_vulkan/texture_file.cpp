@@ -0,0 +1,194 @@
+#include "texture_file.h"
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable<texture_file_header>::value, "the header is read straight out of the mapping");
+
+bool textureFormatSupported(VkFormat const format)
+{
+    switch(format)
+    {
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+    case VK_FORMAT_B8G8R8A8_UNORM:
+    case VK_FORMAT_B8G8R8A8_SRGB:
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+    case VK_FORMAT_BC4_UNORM_BLOCK:
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+        return true;
+    default:
+        return false;
+    }
+}
+
+texture_block_info textureBlockInfo(VkFormat const format)
+{
+    switch(format)
+    {
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+    case VK_FORMAT_BC4_UNORM_BLOCK:
+        return { 4, 8, true };
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+        return { 4, 16, true };
+    default:
+        return { 1, 4, false };
+    }
+}
+
+uint32_t fullMipLevelCount(uint32_t const width, uint32_t const height)
+{
+    uint32_t reply = 1;
+    for(uint32_t largest = std::max(width, height); largest > 1; largest /= 2)
+    {
+        ++reply;
+    }
+    return reply;
+}
+
+VkExtent2D mipLevelExtent(uint32_t const width, uint32_t const height, uint32_t const level)
+{
+    return { std::max(width >> level, 1u), std::max(height >> level, 1u) };
+}
+
+uint64_t mipLevelBytes(VkFormat const format, uint32_t const width, uint32_t const height, uint32_t const level)
+{
+    texture_block_info const block = textureBlockInfo(format);
+    VkExtent2D const extent = mipLevelExtent(width, height, level);
+    uint64_t const blocksWide = (extent.width + block.blockExtent - 1) / block.blockExtent;
+    uint64_t const blocksHigh = (extent.height + block.blockExtent - 1) / block.blockExtent;
+    return blocksWide * blocksHigh * block.blockBytes;
+}
+
+texture_file_header const& validateTextureFile(mapped_file const& file)
+{
+    if(file.size() < sizeof(texture_file_header))
+    {
+        throw std::runtime_error("Texture file is too small to hold a header.");
+    }
+    texture_file_header const& header = *reinterpret_cast<texture_file_header const*>(file.data());
+    if(header.magic != textureFileMagic || header.version != textureFileVersion)
+    {
+        throw std::runtime_error("Not a texture file, or one written by a different version.");
+    }
+    VkFormat const format = static_cast<VkFormat>(header.format);
+    if(!textureFormatSupported(format) || header.width == 0 || header.height == 0)
+    {
+        throw std::runtime_error("Texture file has an unsupported format or is empty.");
+    }
+    uint32_t const fullLevels = fullMipLevelCount(header.width, header.height);
+    if(header.storedLevelCount == 0 || header.storedLevelCount > fullLevels || fullLevels > textureMaxLevels)
+    {
+        throw std::runtime_error("Texture file has an invalid mip chain.");
+    }
+    for(uint32_t level = 0; level < header.storedLevelCount; ++level)
+    {
+        texture_file_level const& stored = header.levels[level];
+        if(stored.offset % textureFileAlignment)
+        {
+            throw std::runtime_error("Texture file levels are not aligned.");
+        }
+        //written so a corrupt offset can't wrap past the end of the file
+        if(stored.size != mipLevelBytes(format, header.width, header.height, level) || stored.offset > file.size() || stored.size > file.size() - stored.offset)
+        {
+            throw std::runtime_error("Texture file is truncated or corrupt.");
+        }
+    }
+    return header;
+}
+
+void writeTextureFile(std::string const& fileName, VkFormat const format, uint32_t const width, uint32_t const height, std::vector<std::vector<uint8_t>> const& levels)
+{
+    texture_file_header header{};
+    header.magic = textureFileMagic;
+    header.version = textureFileVersion;
+    header.format = format;
+    header.width = width;
+    header.height = height;
+    header.storedLevelCount = static_cast<uint32_t>(levels.size());
+
+    uint64_t offset = sizeof(texture_file_header);
+    for(uint32_t level = 0; level < header.storedLevelCount; ++level)
+    {
+        offset = (offset + textureFileAlignment - 1) / textureFileAlignment * textureFileAlignment;
+        header.levels[level] = { offset, levels[level].size() };
+        offset += levels[level].size();
+    }
+
+    std::ofstream file(fileName, std::ios::binary);
+    if(!file.is_open())
+    {
+        throw std::runtime_error("Failed to open " + fileName);
+    }
+    file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    uint64_t written = sizeof(header);
+    char const padding[textureFileAlignment] = {};
+    for(uint32_t level = 0; level < header.storedLevelCount; ++level)
+    {
+        file.write(padding, header.levels[level].offset - written);
+        file.write(reinterpret_cast<char const*>(levels[level].data()), levels[level].size());
+        written = header.levels[level].offset + levels[level].size();
+    }
+    if(!file)
+    {
+        throw std::runtime_error("Failed to write " + fileName);
+    }
+}
+
+std::vector<std::vector<uint8_t>> createCheckerTexture(uint32_t const size, uint32_t const storedLevelCount)
+{
+    std::vector<std::vector<uint8_t>> reply(std::min(storedLevelCount, fullMipLevelCount(size, size)));
+    reply[0].resize(static_cast<size_t>(size) * size * 4);
+    for(uint32_t y = 0; y < size; ++y)
+    {
+        for(uint32_t x = 0; x < size; ++x)
+        {
+            uint8_t* const texel = &reply[0][(static_cast<size_t>(y) * size + x) * 4];
+            bool const light = ((x / 32) ^ (y / 32)) & 1;
+            texel[0] = light ? 230 : 40;
+            texel[1] = static_cast<uint8_t>(x * 255 / size);
+            texel[2] = static_cast<uint8_t>(y * 255 / size);
+            texel[3] = 255;
+        }
+    }
+    //2x2 box filter, the same thing the gpu blit chain approximates
+    for(uint32_t level = 1; level < reply.size(); ++level)
+    {
+        uint32_t const sourceSize = std::max(size >> (level - 1), 1u);
+        uint32_t const levelSize = std::max(size >> level, 1u);
+        reply[level].resize(static_cast<size_t>(levelSize) * levelSize * 4);
+        for(uint32_t y = 0; y < levelSize; ++y)
+        {
+            for(uint32_t x = 0; x < levelSize; ++x)
+            {
+                for(uint32_t channel = 0; channel < 4; ++channel)
+                {
+                    uint32_t sum = 0;
+                    for(uint32_t sample = 0; sample < 4; ++sample)
+                    {
+                        uint32_t const sourceX = std::min(x * 2 + (sample & 1), sourceSize - 1);
+                        uint32_t const sourceY = std::min(y * 2 + (sample >> 1), sourceSize - 1);
+                        sum += reply[level - 1][(static_cast<size_t>(sourceY) * sourceSize + sourceX) * 4 + channel];
+                    }
+                    reply[level][(static_cast<size_t>(y) * levelSize + x) * 4 + channel] = static_cast<uint8_t>(sum / 4);
+                }
+            }
+        }
+    }
+    return reply;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "mapped_file.h"
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <vector>
+
+//.lvtex: a header followed by mip levels stored largest first, each already in the block layout
+//vkCmdCopyBufferToImage expects. files may carry fewer levels than the full chain, the rest are
+//generated on the gpu, which only works for formats that can be blitted.
+constexpr uint32_t textureFileMagic = 0x5845544c;//"LTEX"
+constexpr uint32_t textureFileVersion = 1;
+constexpr uint32_t textureMaxLevels = 16;
+constexpr uint64_t textureFileAlignment = 256;
+
+struct texture_file_level
+{
+    uint64_t offset;//from the start of the file
+    uint64_t size;
+};
+
+struct texture_file_header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t format;//a VkFormat, see textureFormatSupported
+    uint32_t width;
+    uint32_t height;
+    uint32_t storedLevelCount;
+    std::array<texture_file_level, textureMaxLevels> levels;
+};
+
+struct texture_block_info
+{
+    uint32_t blockExtent;//texels along each side of a block, 1 for uncompressed formats
+    uint32_t blockBytes;
+    bool compressed;
+};
+
+//rgba8 in its unorm, srgb and bgra variants and the bc1, bc3, bc4, bc5 and bc7 block formats
+bool textureFormatSupported(VkFormat const format);
+
+texture_block_info textureBlockInfo(VkFormat const format);
+
+uint32_t fullMipLevelCount(uint32_t const width, uint32_t const height);
+
+VkExtent2D mipLevelExtent(uint32_t const width, uint32_t const height, uint32_t const level);
+
+uint64_t mipLevelBytes(VkFormat const format, uint32_t const width, uint32_t const height, uint32_t const level);
+
+//throws if the mapping is not a complete texture file this build understands
+texture_file_header const& validateTextureFile(mapped_file const& file);
+
+//levels holds the stored mips largest first, anything missing from the chain is left to the gpu
+void writeTextureFile(std::string const& fileName, VkFormat const format, uint32_t const width, uint32_t const height, std::vector<std::vector<uint8_t>> const& levels);
+
+//rgba8 checkerboard with storedLevelCount box filtered mips, for exercising the streaming path
+std::vector<std::vector<uint8_t>> createCheckerTexture(uint32_t const size, uint32_t const storedLevelCount);
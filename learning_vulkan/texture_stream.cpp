@@ -0,0 +1,511 @@
+#include "texture_stream.h"
+#include <cstring>
+
+namespace
+{
+    VkImageMemoryBarrier levelBarrier(VkImage const& image, uint32_t const baseLevel, uint32_t const levelCount, VkImageLayout const oldLayout, VkImageLayout const newLayout)
+    {
+        VkImageMemoryBarrier reply{};
+        reply.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        reply.oldLayout = oldLayout;
+        reply.newLayout = newLayout;
+        reply.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        reply.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        reply.image = image;
+        reply.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, baseLevel, levelCount, 0, 1 };
+        switch(oldLayout)
+        {
+        case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL: reply.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT; break;
+        case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL: reply.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT; break;
+        case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL: reply.srcAccessMask = VK_ACCESS_SHADER_READ_BIT; break;
+        default: reply.srcAccessMask = 0; break;
+        }
+        switch(newLayout)
+        {
+        case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL: reply.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT; break;
+        case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL: reply.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT; break;
+        default: reply.dstAccessMask = VK_ACCESS_SHADER_READ_BIT; break;
+        }
+        return reply;
+    }
+
+    VkOffset3D extentOffset(VkExtent2D const& extent)
+    {
+        return { static_cast<int32_t>(extent.width), static_cast<int32_t>(extent.height), 1 };
+    }
+}
+
+texture_streamer::texture_streamer(VkPhysicalDevice const& physicalDevice,
+    VkDevice const& logicalDevice,
+    queue_family_index_t const graphicsFamily,
+    VkDeviceSize const budgetBytes,
+    host_allocator& hostAllocator)
+    : physicalDevice(physicalDevice)
+    , logicalDevice(logicalDevice)
+    , hostAllocator(hostAllocator)
+    , budgetBytes(budgetBytes)
+{
+    updatePools.resize(maxFramesInFlight);
+    updateCommandBuffers.resize(maxFramesInFlight);
+    for(VkCommandPool& pool : updatePools)
+    {
+        pool = createCommandPool(logicalDevice, graphicsFamily, hostAllocator);
+
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = pool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = 1;
+        if(VK_FAILED(vkAllocateCommandBuffers(logicalDevice, &allocInfo, &updateCommandBuffers[&pool - &updatePools[0]])))
+        {
+            throw std::runtime_error("Failed to allocate texture command buffers.");
+        }
+    }
+    loader = std::thread(&texture_streamer::loaderThread, this);
+}
+
+texture_streamer::~texture_streamer()
+{
+    {
+        std::lock_guard<std::mutex> const guard(queueLock);
+        stopping = true;
+    }
+    queueSignal.notify_all();
+    loader.join();
+
+    for(texture_upload const& upload : completedUploads)
+    {
+        destroyRetired({ 0, VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE, upload.stagingBuffer, upload.stagingMemory });
+    }
+    for(retired_texture_resources const& resources : retired)
+    {
+        destroyRetired(resources);
+    }
+    for(std::unique_ptr<streamed_texture> const& texture : textures)
+    {
+        destroyRetired({ 0, texture->image, texture->memory, texture->view });
+    }
+    for(VkCommandPool const& pool : updatePools)
+    {
+        vkDestroyCommandPool(logicalDevice, pool, hostAllocator.callbacks(VK_OBJECT_TYPE_COMMAND_POOL));
+    }
+}
+
+uint32_t texture_streamer::load(std::string const& fileName)
+{
+    textures.push_back(std::make_unique<streamed_texture>());
+    streamed_texture& texture = *textures.back();
+    texture.file.open(fileName);
+    texture.header = validateTextureFile(texture.file);
+    texture.format = static_cast<VkFormat>(texture.header.format);
+    texture.fullLevelCount = fullMipLevelCount(texture.header.width, texture.header.height);
+
+    uint32_t const storedLevels = texture.header.storedLevelCount;
+    if(storedLevels < texture.fullLevelCount)
+    {
+        //the missing tail of the chain comes from a linear blit chain off the last stored level
+        VkFormatProperties formatProperties;
+        vkGetPhysicalDeviceFormatProperties(physicalDevice, texture.format, &formatProperties);
+        VkFormatFeatureFlags const blitFeatures = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+        if(textureBlockInfo(texture.format).compressed || (formatProperties.optimalTilingFeatures & blitFeatures) != blitFeatures)
+        {
+            throw std::runtime_error(fileName + " is missing mips and its format cannot generate them, store the full chain.");
+        }
+    }
+
+    //start from the first level small enough to load straight away, but never past the last one
+    //stored in the file since anything smaller than that can only be regenerated from it
+    uint32_t initialBase = 0;
+    while(initialBase + 1 < storedLevels)
+    {
+        VkExtent2D const extent = mipLevelExtent(texture.header.width, texture.header.height, initialBase);
+        if(std::max(extent.width, extent.height) <= textureInitialExtent)
+        {
+            break;
+        }
+        ++initialBase;
+    }
+    texture.initialBaseLevel = initialBase;
+    texture.desiredBaseLevel = initialBase;
+    texture.residentBaseLevel = texture.fullLevelCount;//nothing yet
+    texture.loadInFlight = true;
+
+    //small enough to stage right here, it is applied by the next update like any other load
+    texture_upload upload = stageLevels(texture, initialBase, storedLevels);
+    {
+        std::lock_guard<std::mutex> const guard(queueLock);
+        completedUploads.push_back(upload);
+    }
+    return static_cast<uint32_t>(textures.size() - 1);
+}
+
+void texture_streamer::requestExtent(uint32_t const textureIndex, VkExtent2D const& onScreenExtent, uint64_t const frameNumber)
+{
+    streamed_texture& texture = *textures[textureIndex];
+    //the smallest level that still has at least a texel per pixel on screen
+    uint32_t level = 0;
+    while(level < texture.initialBaseLevel)
+    {
+        VkExtent2D const next = mipLevelExtent(texture.header.width, texture.header.height, level + 1);
+        if(next.width < onScreenExtent.width || next.height < onScreenExtent.height)
+        {
+            break;
+        }
+        ++level;
+    }
+    texture.desiredBaseLevel = level;
+    texture.lastDemandFrame = frameNumber;
+}
+
+VkCommandBuffer texture_streamer::update(uint32_t const frameIndex, uint64_t const frameNumber)
+{
+    while(!retired.empty() && retired.front().destroyAtFrame <= frameNumber)
+    {
+        destroyRetired(retired.front());
+        retired.pop_front();
+    }
+
+    readyUploads.clear();
+    {
+        std::lock_guard<std::mutex> const guard(queueLock);
+        if(loaderFailure)
+        {
+            std::rethrow_exception(loaderFailure);
+        }
+        readyUploads.swap(completedUploads);
+    }
+
+    VkCommandBuffer const commandBuffer = updateCommandBuffers[frameIndex];
+    bool recording = false;
+    auto const beginRecording = [&]()
+    {
+        if(recording)
+        {
+            return;
+        }
+        vkResetCommandPool(logicalDevice, updatePools[frameIndex], 0);
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        if(VK_FAILED(vkBeginCommandBuffer(commandBuffer, &beginInfo)))
+        {
+            throw std::runtime_error("Failed to begin recording command buffer.");
+        }
+        recording = true;
+    };
+
+    for(texture_upload const& upload : readyUploads)
+    {
+        streamed_texture& texture = *upload.texture;
+        texture.loadInFlight = false;
+        pendingBytes -= upload.reservedBytes;
+        //an eviction since the request was made leaves a gap between this level and what is resident
+        if(upload.endLevel != std::min(texture.residentBaseLevel, texture.header.storedLevelCount))
+        {
+            ++staleUploads;
+            retireStaging(upload, frameNumber);
+            continue;
+        }
+        beginRecording();
+        rebuildResidency(commandBuffer, texture, upload.firstLevel, &upload, frameNumber);
+        levelsLoaded += upload.endLevel - upload.firstLevel;
+        retireStaging(upload, frameNumber);
+    }
+    readyUploads.clear();
+
+    for(std::unique_ptr<streamed_texture> const& texturePointer : textures)
+    {
+        streamed_texture& texture = *texturePointer;
+        if(texture.lastDemandFrame + textureIdleFrames < frameNumber)
+        {
+            texture.desiredBaseLevel = texture.initialBaseLevel;
+        }
+        if(texture.loadInFlight || texture.desiredBaseLevel >= texture.residentBaseLevel)
+        {
+            continue;
+        }
+        //one level at a time so a texture that scrolls off screen mid stream has not wasted much
+        uint32_t const level = texture.residentBaseLevel - 1;
+        VkDeviceSize const bytesNeeded = mipLevelBytes(texture.format, texture.header.width, texture.header.height, level);
+        if(residentBytes() + pendingBytes + bytesNeeded > budgetBytes)
+        {
+            beginRecording();
+            if(!evictForRoom(bytesNeeded, texture, commandBuffer, frameNumber))
+            {
+                continue;
+            }
+        }
+        texture.loadInFlight = true;
+        pendingBytes += bytesNeeded;
+        {
+            std::lock_guard<std::mutex> const guard(queueLock);
+            levelRequests.emplace_back(&texture, level);
+        }
+        queueSignal.notify_one();
+    }
+
+    if(!recording)
+    {
+        return VK_NULL_HANDLE;
+    }
+    if(VK_FAILED(vkEndCommandBuffer(commandBuffer)))
+    {
+        throw std::runtime_error("Failed to record command buffer.");
+    }
+    return commandBuffer;
+}
+
+VkDeviceSize texture_streamer::residentBytes() const
+{
+    VkDeviceSize reply = 0;
+    for(std::unique_ptr<streamed_texture> const& texture : textures)
+    {
+        reply += texture->residentBytes;
+    }
+    return reply;
+}
+
+void texture_streamer::writeReportJson(std::ostream& out) const
+{
+    out << "{\"textures\":" << textures.size()
+        << ",\"residentBytes\":" << residentBytes()
+        << ",\"pendingBytes\":" << pendingBytes
+        << ",\"budgetBytes\":" << budgetBytes
+        << ",\"levelsLoaded\":" << levelsLoaded
+        << ",\"levelsEvicted\":" << levelsEvicted
+        << ",\"levelsGenerated\":" << levelsGenerated
+        << ",\"staleUploads\":" << staleUploads
+        << ",\"residentBaseLevels\":[";
+    for(std::unique_ptr<streamed_texture> const& texture : textures)
+    {
+        out << (&texture == &textures.front() ? "" : ",") << texture->residentBaseLevel;
+    }
+    out << "]}\n";
+}
+
+void texture_streamer::loaderThread()
+{
+    try
+    {
+        for(;;)
+        {
+            std::unique_lock<std::mutex> lock(queueLock);
+            queueSignal.wait(lock, [this]() { return stopping || !levelRequests.empty(); });
+            if(stopping)
+            {
+                return;
+            }
+            auto const[texture, level] = levelRequests.front();
+            levelRequests.pop_front();
+            lock.unlock();
+
+            //the page faults pulling the level in from disk happen here rather than on the frame
+            texture_upload upload = stageLevels(*texture, level, level + 1);
+            upload.reservedBytes = mipLevelBytes(texture->format, texture->header.width, texture->header.height, level);
+
+            lock.lock();
+            completedUploads.push_back(upload);
+        }
+    }
+    catch(...)
+    {
+        std::lock_guard<std::mutex> const guard(queueLock);
+        loaderFailure = std::current_exception();
+    }
+}
+
+texture_upload texture_streamer::stageLevels(streamed_texture& texture, uint32_t const firstLevel, uint32_t const endLevel)
+{
+    texture_upload reply;
+    reply.texture = &texture;
+    reply.firstLevel = firstLevel;
+    reply.endLevel = endLevel;
+
+    //offsets have to be a multiple of the block size, 16 covers every supported format
+    VkDeviceSize stagingSize = 0;
+    for(uint32_t level = firstLevel; level < endLevel; ++level)
+    {
+        reply.levelOffsets[level] = stagingSize;
+        stagingSize = (stagingSize + texture.header.levels[level].size + 15) / 16 * 16;
+    }
+    std::tie(reply.stagingBuffer, reply.stagingMemory) = createBuffer(physicalDevice,
+        logicalDevice,
+        stagingSize,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        hostAllocator);
+
+    void* mapping;
+    vkMapMemory(logicalDevice, reply.stagingMemory, 0, stagingSize, 0, &mapping);
+    for(uint32_t level = firstLevel; level < endLevel; ++level)
+    {
+        texture_file_level const& stored = texture.header.levels[level];
+        std::memcpy(static_cast<uint8_t*>(mapping) + reply.levelOffsets[level], texture.file.data() + stored.offset, stored.size);
+        texture.file.release(stored.offset, stored.size);
+    }
+    vkUnmapMemory(logicalDevice, reply.stagingMemory);
+    return reply;
+}
+
+void texture_streamer::rebuildResidency(VkCommandBuffer const& commandBuffer, streamed_texture& texture, uint32_t const newBaseLevel, texture_upload const* upload, uint64_t const frameNumber)
+{
+    uint32_t const width = texture.header.width;
+    uint32_t const height = texture.header.height;
+    uint32_t const levelCount = texture.fullLevelCount - newBaseLevel;
+    uint32_t const oldBaseLevel = texture.residentBaseLevel;
+
+    auto const[image, memory] = createImage(physicalDevice,
+        logicalDevice,
+        mipLevelExtent(width, height, newBaseLevel),
+        levelCount,
+        texture.format,
+        VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+        hostAllocator);
+    VkMemoryRequirements memoryRequirements;
+    vkGetImageMemoryRequirements(logicalDevice, image, &memoryRequirements);
+
+    std::array<VkImageMemoryBarrier, 3> barriers;
+    barriers[0] = levelBarrier(image, 0, levelCount, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    uint32_t barrierCount = 1;
+    if(texture.image != VK_NULL_HANDLE)
+    {
+        barriers[barrierCount++] = levelBarrier(texture.image, 0, texture.fullLevelCount - oldBaseLevel, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+    }
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, barrierCount, barriers.data());
+
+    //surviving levels move across on the gpu, nothing goes back to the file for them
+    if(texture.image != VK_NULL_HANDLE)
+    {
+        std::array<VkImageCopy, textureMaxLevels> copies{};
+        uint32_t copyCount = 0;
+        for(uint32_t level = std::max(newBaseLevel, oldBaseLevel); level < texture.fullLevelCount; ++level)
+        {
+            VkImageCopy& copy = copies[copyCount++];
+            copy.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - oldBaseLevel, 0, 1 };
+            copy.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - newBaseLevel, 0, 1 };
+            VkExtent2D const extent = mipLevelExtent(width, height, level);
+            copy.extent = { extent.width, extent.height, 1 };
+        }
+        vkCmdCopyImage(commandBuffer, texture.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, copyCount, copies.data());
+    }
+
+    if(upload)
+    {
+        std::array<VkBufferImageCopy, textureMaxLevels> copies{};
+        uint32_t copyCount = 0;
+        for(uint32_t level = upload->firstLevel; level < upload->endLevel; ++level)
+        {
+            VkBufferImageCopy& copy = copies[copyCount++];
+            copy.bufferOffset = upload->levelOffsets[level];
+            copy.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - newBaseLevel, 0, 1 };
+            VkExtent2D const extent = mipLevelExtent(width, height, level);
+            copy.imageExtent = { extent.width, extent.height, 1 };
+        }
+        vkCmdCopyBufferToImage(commandBuffer, upload->stagingBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, copyCount, copies.data());
+    }
+
+    uint32_t const storedLevels = texture.header.storedLevelCount;
+    if(texture.image == VK_NULL_HANDLE && storedLevels < texture.fullLevelCount)
+    {
+        //each generated level is blitted from the one above it once that has been written
+        for(uint32_t level = storedLevels; level < texture.fullLevelCount; ++level)
+        {
+            VkImageMemoryBarrier const toSource = levelBarrier(image, level - 1 - newBaseLevel, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &toSource);
+
+            VkImageBlit blit{};
+            blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - 1 - newBaseLevel, 0, 1 };
+            blit.srcOffsets[1] = extentOffset(mipLevelExtent(width, height, level - 1));
+            blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - newBaseLevel, 0, 1 };
+            blit.dstOffsets[1] = extentOffset(mipLevelExtent(width, height, level));
+            vkCmdBlitImage(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+            ++levelsGenerated;
+        }
+        //blit sources are in TRANSFER_SRC, the levels above them and the last one are still TRANSFER_DST
+        uint32_t const firstSource = storedLevels - 1 - newBaseLevel;
+        uint32_t const lastLevel = levelCount - 1;
+        barrierCount = 0;
+        if(firstSource > 0)
+        {
+            barriers[barrierCount++] = levelBarrier(image, 0, firstSource, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        }
+        barriers[barrierCount++] = levelBarrier(image, firstSource, lastLevel - firstSource, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        barriers[barrierCount++] = levelBarrier(image, lastLevel, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    }
+    else
+    {
+        barriers[0] = levelBarrier(image, 0, levelCount, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        barrierCount = 1;
+    }
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, barrierCount, barriers.data());
+
+    if(texture.image != VK_NULL_HANDLE)
+    {
+        retired.push_back({ frameNumber + maxFramesInFlight, texture.image, texture.memory, texture.view });
+    }
+    texture.image = image;
+    texture.memory = memory;
+    texture.view = createImageView(image, texture.format, levelCount, logicalDevice, hostAllocator);
+    texture.residentBytes = memoryRequirements.size;
+    texture.residentBaseLevel = newBaseLevel;
+    ++texture.generation;
+}
+
+bool texture_streamer::evictForRoom(VkDeviceSize const bytesNeeded, streamed_texture const& requester, VkCommandBuffer const& commandBuffer, uint64_t const frameNumber)
+{
+    while(residentBytes() + pendingBytes + bytesNeeded > budgetBytes)
+    {
+        //the least recently wanted texture holding more than it currently needs gives up its top level.
+        //levels below the last stored one cannot be rebuilt without it, so those always stay.
+        streamed_texture* victim = nullptr;
+        for(std::unique_ptr<streamed_texture> const& candidate : textures)
+        {
+            if(candidate.get() == &requester
+                || candidate->loadInFlight
+                || candidate->image == VK_NULL_HANDLE
+                || candidate->residentBaseLevel >= candidate->desiredBaseLevel
+                || candidate->residentBaseLevel + 1 >= candidate->header.storedLevelCount)
+            {
+                continue;
+            }
+            if(!victim || candidate->lastDemandFrame < victim->lastDemandFrame)
+            {
+                victim = candidate.get();
+            }
+        }
+        if(!victim)
+        {
+            return false;
+        }
+        rebuildResidency(commandBuffer, *victim, victim->residentBaseLevel + 1, nullptr, frameNumber);
+        ++levelsEvicted;
+    }
+    return true;
+}
+
+void texture_streamer::retireStaging(texture_upload const& upload, uint64_t const frameNumber)
+{
+    retired_texture_resources resources;
+    resources.destroyAtFrame = frameNumber + maxFramesInFlight;
+    resources.stagingBuffer = upload.stagingBuffer;
+    resources.stagingMemory = upload.stagingMemory;
+    retired.push_back(resources);
+}
+
+void texture_streamer::destroyRetired(retired_texture_resources const& resources)
+{
+    if(resources.view != VK_NULL_HANDLE)
+    {
+        vkDestroyImageView(logicalDevice, resources.view, hostAllocator.callbacks(VK_OBJECT_TYPE_IMAGE_VIEW));
+    }
+    if(resources.image != VK_NULL_HANDLE)
+    {
+        vkDestroyImage(logicalDevice, resources.image, hostAllocator.callbacks(VK_OBJECT_TYPE_IMAGE));
+        vkFreeMemory(logicalDevice, resources.memory, hostAllocator.callbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+    }
+    if(resources.stagingBuffer != VK_NULL_HANDLE)
+    {
+        vkDestroyBuffer(logicalDevice, resources.stagingBuffer, hostAllocator.callbacks(VK_OBJECT_TYPE_BUFFER));
+        vkFreeMemory(logicalDevice, resources.stagingMemory, hostAllocator.callbacks(VK_OBJECT_TYPE_DEVICE_MEMORY));
+    }
+}
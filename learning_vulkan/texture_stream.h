@@ -0,0 +1,127 @@
+#pragma once
+
+#include "texture_file.h"
+#include "vulkan_init.h"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+constexpr uint32_t textureInitialExtent = 64;//levels this size and smaller are loaded up front
+constexpr uint64_t textureIdleFrames = 300;//frames without demand before a texture gives up its extra levels
+constexpr VkDeviceSize textureDefaultBudget = 256ull * 1024 * 1024;
+
+struct streamed_texture
+{
+    mapped_file file;
+    texture_file_header header{};
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    uint32_t fullLevelCount = 0;
+
+    //the image only holds levels [residentBaseLevel, fullLevelCount), so its level 0 is residentBaseLevel
+    VkImage image = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkImageView view = VK_NULL_HANDLE;
+    VkDeviceSize residentBytes = 0;
+    uint32_t residentBaseLevel = 0;
+    uint32_t generation = 0;//bumped whenever view changes, descriptors holding the old one must be rewritten
+
+    uint32_t initialBaseLevel = 0;
+    uint32_t desiredBaseLevel = 0;
+    uint64_t lastDemandFrame = 0;
+    bool loadInFlight = false;
+};
+
+//levels [firstLevel, endLevel) of one texture packed into a staging buffer
+struct texture_upload
+{
+    streamed_texture* texture = nullptr;
+    uint32_t firstLevel = 0;
+    uint32_t endLevel = 0;
+    VkDeviceSize reservedBytes = 0;//counted against the budget until applied
+    VkBuffer stagingBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory stagingMemory = VK_NULL_HANDLE;
+    std::array<VkDeviceSize, textureMaxLevels> levelOffsets{};
+};
+
+//kept alive until every frame that could still be reading it has retired
+struct retired_texture_resources
+{
+    uint64_t destroyAtFrame = 0;
+    VkImage image = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkImageView view = VK_NULL_HANDLE;
+    VkBuffer stagingBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory stagingMemory = VK_NULL_HANDLE;
+};
+
+//textures start with only their small levels resident. larger levels are read from the mapped
+//file on a loader thread as on screen demand asks for them, and idle textures give theirs back
+//when a load would go over budgetBytes. a change in residency rebuilds the image at the new size
+//with the surviving levels copied across on the gpu, so memory really is returned.
+class texture_streamer
+{
+public:
+    texture_streamer(VkPhysicalDevice const& physicalDevice,
+        VkDevice const& logicalDevice,
+        queue_family_index_t const graphicsFamily,
+        VkDeviceSize const budgetBytes,
+        host_allocator& hostAllocator);
+    ~texture_streamer();//the device must be idle
+
+    texture_streamer(texture_streamer const&) = delete;
+    texture_streamer& operator=(texture_streamer const&) = delete;
+
+    uint32_t load(std::string const& fileName);
+
+    //demand feedback, about how many pixels the texture covers on screen this frame
+    void requestExtent(uint32_t const textureIndex, VkExtent2D const& onScreenExtent, uint64_t const frameNumber);
+
+    //applies finished loads and any evictions and kicks off new loads. frameIndex's previous
+    //submission must have retired. submit the result ahead of anything sampling the textures,
+    //null when there was nothing to record.
+    VkCommandBuffer update(uint32_t const frameIndex, uint64_t const frameNumber);
+
+    streamed_texture const& texture(uint32_t const textureIndex) const { return *textures[textureIndex]; }
+    uint32_t textureCount() const { return static_cast<uint32_t>(textures.size()); }
+    VkDeviceSize residentBytes() const;
+
+    void writeReportJson(std::ostream& out) const;
+
+private:
+    void loaderThread();
+    texture_upload stageLevels(streamed_texture& texture, uint32_t const firstLevel, uint32_t const endLevel);
+    void rebuildResidency(VkCommandBuffer const& commandBuffer, streamed_texture& texture, uint32_t const newBaseLevel, texture_upload const* upload, uint64_t const frameNumber);
+    bool evictForRoom(VkDeviceSize const bytesNeeded, streamed_texture const& requester, VkCommandBuffer const& commandBuffer, uint64_t const frameNumber);
+    void retireStaging(texture_upload const& upload, uint64_t const frameNumber);
+    void destroyRetired(retired_texture_resources const& resources);
+
+    VkPhysicalDevice physicalDevice;
+    VkDevice logicalDevice;
+    host_allocator& hostAllocator;
+    VkDeviceSize const budgetBytes;
+
+    vector<std::unique_ptr<streamed_texture>> textures;
+    vector<VkCommandPool> updatePools;//one per frame in flight
+    vector<VkCommandBuffer> updateCommandBuffers;
+    std::deque<retired_texture_resources> retired;
+    vector<texture_upload> readyUploads;//swapped with completedUploads each update
+    VkDeviceSize pendingBytes = 0;
+
+    uint64_t levelsLoaded = 0;
+    uint64_t levelsEvicted = 0;
+    uint64_t levelsGenerated = 0;
+    uint64_t staleUploads = 0;
+
+    //shared with the loader thread
+    std::mutex queueLock;
+    std::condition_variable queueSignal;
+    std::deque<std::tuple<streamed_texture*, uint32_t>> levelRequests;
+    vector<texture_upload> completedUploads;
+    std::exception_ptr loaderFailure;
+    bool stopping = false;
+    std::thread loader;//last so everything it touches exists before it starts
+};
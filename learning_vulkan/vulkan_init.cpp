@@ -1,4 +1,5 @@
 #include "vulkan_init.h"
+#include <array>
 #include <fstream>
 
 swap_chain_support_details querySwapChainSupport(VkPhysicalDevice const& device, VkSurfaceKHR const& surface)
@@ -26,7 +27,7 @@ swap_chain_support_details querySwapChainSupport(VkPhysicalDevice const& device,
     return reply;
 }
 
-VkInstance createInstance()
+VkInstance createInstance(host_allocator& hostAllocator, bool const presentationSupport)
 {
     if(enableValidationLayers)
     {
@@ -45,13 +46,16 @@ VkInstance createInstance()
     creationInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
     creationInfo.pApplicationInfo = &appInfo;
 
-    uint32_t glfwExtensionCount = 0;
-    char const** glfwExtensions;
+    if(presentationSupport)
+    {
+        uint32_t glfwExtensionCount = 0;
+        char const** glfwExtensions;
 
-    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
 
-    creationInfo.enabledExtensionCount = glfwExtensionCount;
-    creationInfo.ppEnabledExtensionNames = glfwExtensions;
+        creationInfo.enabledExtensionCount = glfwExtensionCount;
+        creationInfo.ppEnabledExtensionNames = glfwExtensions;
+    }
 
     if(enableValidationLayers)
     {
@@ -64,7 +68,7 @@ VkInstance createInstance()
     }
 
     VkInstance vulkanInstance;
-    if(VK_FAILED(vkCreateInstance(&creationInfo, nullptr, &vulkanInstance)))
+    if(VK_FAILED(vkCreateInstance(&creationInfo, hostAllocator.callbacks(VK_OBJECT_TYPE_INSTANCE), &vulkanInstance)))
     {
         throw std::runtime_error("Failed to create vulkan instance.");
     }
@@ -150,6 +154,21 @@ queue_family_indices findQueueFamilies(VkPhysicalDevice const& device, VkQueueFl
         }
         ++index;
     };
+
+    //a family with compute but not graphics is usually backed by separate hardware queues, work
+    //submitted there runs alongside rendering. without one compute shares the graphics family.
+    for(auto const& queueFamily : queueFamilies)
+    {
+        if((queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT) && !(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT))
+        {
+            reply.computeFamily = static_cast<queue_family_index_t>(&queueFamily - &queueFamilies[0]);
+            break;
+        }
+    }
+    if(!reply.computeFamily)
+    {
+        reply.computeFamily = reply.graphicsFamily;
+    }
     return reply;
 }
 
@@ -215,7 +234,7 @@ VkPhysicalDevice pickPhysicalDevice(VkInstance const& vulkanInstance, VkSurfaceK
     return physicalDevice;
 }
 
-std::tuple<VkDevice, queue_family_index_t, queue_family_index_t> createLogicalDevice(VkPhysicalDevice const& physicalDevice, VkSurfaceKHR const& surface, VkQueueFlagBits const requirements, vector<const char*> const& deviceExtensions)
+std::tuple<VkDevice, queue_family_index_t, queue_family_index_t, queue_family_index_t> createLogicalDevice(VkPhysicalDevice const& physicalDevice, VkSurfaceKHR const& surface, VkQueueFlagBits const requirements, vector<const char*> const& deviceExtensions, VkPhysicalDeviceFeatures const& deviceFeatures, host_allocator& hostAllocator)
 {
     queue_family_indices indices = findQueueFamilies(physicalDevice, requirements, surface);
     if(!indices.isComplete())
@@ -228,16 +247,16 @@ std::tuple<VkDevice, queue_family_index_t, queue_family_index_t> createLogicalDe
     {
         indices.graphicsFamily.value(),
         indices.presentationFamily.value(),
+        indices.computeFamily.value(),
     };
 
     constexpr float queuePriority = 1.0f;
-    VkPhysicalDeviceFeatures deviceFeatures{};
 
     for(queue_family_index_t const queueFamily : uniqueQueueFamilies)
     {
         VkDeviceQueueCreateInfo queueCreateInfo{};
         queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-        queueCreateInfo.queueFamilyIndex = indices.graphicsFamily.value();
+        queueCreateInfo.queueFamilyIndex = queueFamily;
         queueCreateInfo.queueCount = 1;
         queueCreateInfo.pQueuePriorities = &queuePriority;
         queueCreateInfos.push_back(queueCreateInfo);
@@ -252,7 +271,7 @@ std::tuple<VkDevice, queue_family_index_t, queue_family_index_t> createLogicalDe
     deviceCreateInfo.ppEnabledExtensionNames = deviceExtensions.data();
 
     VkDevice logicalDevice;
-    if(VK_FAILED(vkCreateDevice(physicalDevice, &deviceCreateInfo, nullptr, &logicalDevice)))
+    if(VK_FAILED(vkCreateDevice(physicalDevice, &deviceCreateInfo, hostAllocator.callbacks(VK_OBJECT_TYPE_DEVICE), &logicalDevice)))
     {
         throw std::runtime_error("Failed to create the logical device.");
     }
@@ -260,14 +279,15 @@ std::tuple<VkDevice, queue_family_index_t, queue_family_index_t> createLogicalDe
     {
         logicalDevice, 
         indices.graphicsFamily.value(), 
-        indices.presentationFamily.value()
+        indices.presentationFamily.value(),
+        indices.computeFamily.value()
     };
 }
 
-VkSurfaceKHR createSurface(VkInstance const& instance, GLFWwindow* window)
+VkSurfaceKHR createSurface(VkInstance const& instance, GLFWwindow* window, host_allocator& hostAllocator)
 {
     VkSurfaceKHR reply{};
-    if(VK_FAILED(glfwCreateWindowSurface(instance, window, nullptr, &reply)))
+    if(VK_FAILED(glfwCreateWindowSurface(instance, window, hostAllocator.callbacks(VK_OBJECT_TYPE_SURFACE_KHR), &reply)))
     {
         throw std::runtime_error("Failed to create the window surface.");
     }
@@ -315,7 +335,7 @@ VkExtent2D chooseSwapExtent(VkSurfaceCapabilitiesKHR const& capabilities)
     }
 }
 
-VkSwapchainKHR createSwapChain(swap_chain_support_details const& swapChainSupport, VkSurfaceKHR const& surface, VkPhysicalDevice const& physicalDevice, VkDevice const& logicalDevice)
+VkSwapchainKHR createSwapChain(swap_chain_support_details const& swapChainSupport, VkSurfaceKHR const& surface, VkPhysicalDevice const& physicalDevice, VkDevice const& logicalDevice, host_allocator& hostAllocator)
 {
     VkSurfaceFormatKHR const surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
     VkPresentModeKHR const presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
@@ -335,7 +355,8 @@ VkSwapchainKHR createSwapChain(swap_chain_support_details const& swapChainSuppor
     creationInfo.imageColorSpace = surfaceFormat.colorSpace;
     creationInfo.imageExtent = extent;
     creationInfo.imageArrayLayers = 1;
-    creationInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    //transfer destination where allowed so a frame rendered at a lower resolution can be blitted in
+    creationInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | (swapChainSupport.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT);
 
     queue_family_indices indices = findQueueFamilies(physicalDevice, queueRequirements, surface);
     uint32_t const queueFamilyIndices[] = { indices.graphicsFamily.value(), indices.presentationFamily.value() };
@@ -356,44 +377,57 @@ VkSwapchainKHR createSwapChain(swap_chain_support_details const& swapChainSuppor
     creationInfo.oldSwapchain = VK_NULL_HANDLE;//for when previous swapchain is invalidated e.g. by resizing window, ignored for first project to keep simple.
 
     VkSwapchainKHR reply;
-    if(VK_FAILED(vkCreateSwapchainKHR(logicalDevice, &creationInfo, nullptr, &reply)))
+    if(VK_FAILED(vkCreateSwapchainKHR(logicalDevice, &creationInfo, hostAllocator.callbacks(VK_OBJECT_TYPE_SWAPCHAIN_KHR), &reply)))
     {
         throw std::runtime_error("Failed to create the swap chain.");
     }
     return reply;
 }
 
-image_views createImageViews(image_list const& images, VkFormat const& format, VkDevice const& logicalDevice)
+VkImageView createImageView(VkImage const& image, VkFormat const& format, uint32_t const levelCount, VkDevice const& logicalDevice, host_allocator& hostAllocator)
+{
+    VkImageViewCreateInfo creationInfo{};
+    creationInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    creationInfo.image = image;
+    creationInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    creationInfo.format = format;
+    creationInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    creationInfo.subresourceRange.baseMipLevel = 0;
+    creationInfo.subresourceRange.levelCount = levelCount;
+    creationInfo.subresourceRange.baseArrayLayer = 0;
+    creationInfo.subresourceRange.layerCount = 1;
+
+    VkImageView reply;
+    if(VK_FAILED(vkCreateImageView(logicalDevice, &creationInfo, hostAllocator.callbacks(VK_OBJECT_TYPE_IMAGE_VIEW), &reply)))
+    {
+        throw std::runtime_error("Failed to create the image views.");
+    }
+    return reply;
+}
+
+image_views createImageViews(image_list const& images, VkFormat const& format, VkDevice const& logicalDevice, host_allocator& hostAllocator)
 {
     vector<VkImageView> reply;
     reply.resize(images.size());
     for(VkImage const& image : images)
     {
-        VkImageViewCreateInfo creationInfo{};
-        creationInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-        creationInfo.image = image;
-        creationInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-        creationInfo.format = format;
-        creationInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        creationInfo.subresourceRange.baseMipLevel = 0;
-        creationInfo.subresourceRange.levelCount = 1;
-        creationInfo.subresourceRange.baseArrayLayer = 0;
-        creationInfo.subresourceRange.layerCount = 1;
-        if(VK_FAILED(vkCreateImageView(logicalDevice, &creationInfo, nullptr, &reply[&image - &images[0]])))
-        {
-            throw std::runtime_error("Failed to create the image views.");
-        }
+        reply[&image - &images[0]] = createImageView(image, format, 1, logicalDevice, hostAllocator);
     }
     return reply;
 }
 
-std::tuple<VkPipeline, VkPipelineLayout> createGraphicsPipeline(VkDevice const& logicalDevice, VkExtent2D const& swapchainExtent, VkRenderPass const& renderPass)
+std::tuple<VkPipeline, VkPipelineLayout> createGraphicsPipeline(VkDevice const& logicalDevice,
+    VkExtent2D const& swapchainExtent,
+    VkRenderPass const& renderPass,
+    VkPipelineCache const& pipelineCache,
+    graphics_pipeline_description const& description,
+    host_allocator& hostAllocator)
 {
     //todo: combine first 2 steps if possible
-    vector<char> vertShaderCode = readFile("shaders/vert.spv");
-    vector<char> fragShaderCode = readFile("shaders/frag.spv");
-    VkShaderModule vertShaderModule = createShaderModule(vertShaderCode, logicalDevice);
-    VkShaderModule fragShaderModule = createShaderModule(fragShaderCode, logicalDevice);
+    vector<char> vertShaderCode = readFile(description.vertexShader);
+    vector<char> fragShaderCode = readFile(description.fragmentShader);
+    VkShaderModule vertShaderModule = createShaderModule(vertShaderCode, logicalDevice, hostAllocator);
+    VkShaderModule fragShaderModule = createShaderModule(fragShaderCode, logicalDevice, hostAllocator);
 
     VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
     vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -415,10 +449,14 @@ std::tuple<VkPipeline, VkPipelineLayout> createGraphicsPipeline(VkDevice const&
 
     VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
     vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(description.vertexBindings.size());
+    vertexInputInfo.pVertexBindingDescriptions = description.vertexBindings.data();
+    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(description.vertexAttributes.size());
+    vertexInputInfo.pVertexAttributeDescriptions = description.vertexAttributes.data();
 
     VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
     inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    inputAssembly.topology = description.topology;
     inputAssembly.primitiveRestartEnable = VK_FALSE;
 
     VkViewport viewport{};
@@ -440,13 +478,19 @@ std::tuple<VkPipeline, VkPipelineLayout> createGraphicsPipeline(VkDevice const&
     viewportState.scissorCount = 1;
     viewportState.pScissors = &scissor;
 
+    VkDynamicState const dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    VkPipelineDynamicStateCreateInfo dynamicState{};
+    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount = 2;
+    dynamicState.pDynamicStates = dynamicStates;
+
     VkPipelineRasterizationStateCreateInfo rasterizer{};
     rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
     rasterizer.depthClampEnable = VK_FALSE;
     rasterizer.rasterizerDiscardEnable = VK_FALSE;
     rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
     rasterizer.lineWidth = 1.0f;
-    rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
+    rasterizer.cullMode = description.cullMode;
     rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
     
     VkPipelineMultisampleStateCreateInfo multisampling{};
@@ -458,6 +502,16 @@ std::tuple<VkPipeline, VkPipelineLayout> createGraphicsPipeline(VkDevice const&
         | VK_COLOR_COMPONENT_G_BIT
         | VK_COLOR_COMPONENT_B_BIT
         | VK_COLOR_COMPONENT_A_BIT;
+    if(description.alphaBlend)
+    {
+        colorBlendAttachment.blendEnable = VK_TRUE;
+        colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+        colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+        colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+        colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+        colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+        colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+    }
 
     VkPipelineColorBlendStateCreateInfo colorBlending{};
     colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
@@ -466,9 +520,11 @@ std::tuple<VkPipeline, VkPipelineLayout> createGraphicsPipeline(VkDevice const&
 
     VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
     pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(description.setLayouts.size());
+    pipelineLayoutInfo.pSetLayouts = description.setLayouts.data();
 
     VkPipelineLayout pipelineLayout;
-    if(VK_FAILED(vkCreatePipelineLayout(logicalDevice, &pipelineLayoutInfo, nullptr, &pipelineLayout)))
+    if(VK_FAILED(vkCreatePipelineLayout(logicalDevice, &pipelineLayoutInfo, hostAllocator.callbacks(VK_OBJECT_TYPE_PIPELINE_LAYOUT), &pipelineLayout)))
     {
         throw std::runtime_error("Failed to create the pipeline layout.");
     }
@@ -483,18 +539,58 @@ std::tuple<VkPipeline, VkPipelineLayout> createGraphicsPipeline(VkDevice const&
     pipelineInfo.pRasterizationState = &rasterizer;
     pipelineInfo.pMultisampleState = &multisampling;
     pipelineInfo.pColorBlendState = &colorBlending;
+    pipelineInfo.pDynamicState = description.dynamicViewport ? &dynamicState : nullptr;
     pipelineInfo.layout = pipelineLayout;
     pipelineInfo.renderPass = renderPass;
 
     VkPipeline reply;
-    if(VK_FAILED(vkCreateGraphicsPipelines(logicalDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &reply)))
+    if(VK_FAILED(vkCreateGraphicsPipelines(logicalDevice, pipelineCache, 1, &pipelineInfo, hostAllocator.callbacks(VK_OBJECT_TYPE_PIPELINE), &reply)))
     {
         throw std::runtime_error("Failed to create graphics pipeline.");
     }
 
     //todo: these wont be called if error is thrown above, needs raii
-    vkDestroyShaderModule(logicalDevice, vertShaderModule, nullptr);
-    vkDestroyShaderModule(logicalDevice, fragShaderModule, nullptr);
+    vkDestroyShaderModule(logicalDevice, vertShaderModule, hostAllocator.callbacks(VK_OBJECT_TYPE_SHADER_MODULE));
+    vkDestroyShaderModule(logicalDevice, fragShaderModule, hostAllocator.callbacks(VK_OBJECT_TYPE_SHADER_MODULE));
+
+    return { reply, pipelineLayout };
+}
+
+std::tuple<VkPipeline, VkPipelineLayout> createComputePipeline(VkDevice const& logicalDevice,
+    std::string const& computeShader,
+    vector<VkDescriptorSetLayout> const& setLayouts,
+    VkPipelineCache const& pipelineCache,
+    host_allocator& hostAllocator)
+{
+    VkShaderModule shaderModule = createShaderModule(readFile(computeShader), logicalDevice, hostAllocator);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+    pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+
+    VkPipelineLayout pipelineLayout;
+    if(VK_FAILED(vkCreatePipelineLayout(logicalDevice, &pipelineLayoutInfo, hostAllocator.callbacks(VK_OBJECT_TYPE_PIPELINE_LAYOUT), &pipelineLayout)))
+    {
+        throw std::runtime_error("Failed to create the compute pipeline layout.");
+    }
+
+    VkComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineInfo.stage.module = shaderModule;
+    pipelineInfo.stage.pName = "main";
+    pipelineInfo.layout = pipelineLayout;
+
+    VkPipeline reply;
+    if(VK_FAILED(vkCreateComputePipelines(logicalDevice, pipelineCache, 1, &pipelineInfo, hostAllocator.callbacks(VK_OBJECT_TYPE_PIPELINE), &reply)))
+    {
+        throw std::runtime_error("Failed to create compute pipeline.");
+    }
+
+    //todo: same as createGraphicsPipeline, leaks the module if creation throws
+    vkDestroyShaderModule(logicalDevice, shaderModule, hostAllocator.callbacks(VK_OBJECT_TYPE_SHADER_MODULE));
 
     return { reply, pipelineLayout };
 }
@@ -514,31 +610,32 @@ vector<char> readFile(std::string const& fileName)
     return reply;
 }
 
-VkShaderModule createShaderModule(vector<char> const& code, VkDevice const& logicalDevice)
+VkShaderModule createShaderModule(vector<char> const& code, VkDevice const& logicalDevice, host_allocator& hostAllocator)
 {
     VkShaderModuleCreateInfo creationInfo{};
     creationInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
     creationInfo.codeSize = code.size();
     creationInfo.pCode = reinterpret_cast<uint32_t const*>(code.data());
     VkShaderModule reply;
-    if(VK_FAILED(vkCreateShaderModule(logicalDevice, &creationInfo, nullptr, &reply)))
+    if(VK_FAILED(vkCreateShaderModule(logicalDevice, &creationInfo, hostAllocator.callbacks(VK_OBJECT_TYPE_SHADER_MODULE), &reply)))
     {
         throw std::runtime_error("Failed to create a shader module.");
     }
     return reply;
 }
 
-VkRenderPass createRenderPass(VkDevice const& logicalDevice, VkFormat const& format)
+VkRenderPass createRenderPass(VkDevice const& logicalDevice, VkFormat const& format, VkImageLayout const finalLayout, host_allocator& hostAllocator, VkAttachmentLoadOp const loadOp)
 {
+    bool const drawOver = loadOp == VK_ATTACHMENT_LOAD_OP_LOAD;
     VkAttachmentDescription colorAttachment{};
     colorAttachment.format = format;
     colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-    colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    colorAttachment.loadOp = loadOp;
     colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
     colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    colorAttachment.initialLayout = drawOver ? finalLayout : VK_IMAGE_LAYOUT_UNDEFINED;
+    colorAttachment.finalLayout = finalLayout;
 
     VkAttachmentReference colorAttachmentRef{};
     colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
@@ -548,13 +645,36 @@ VkRenderPass createRenderPass(VkDevice const& logicalDevice, VkFormat const& for
     subpass.colorAttachmentCount = 1;
     subpass.pColorAttachments = &colorAttachmentRef;
 
-    VkSubpassDependency dependency{};
+    std::array<VkSubpassDependency, 2> dependencies{};
+    VkSubpassDependency& dependency = dependencies[0];
     dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
     dependency.dstSubpass = 0;
     dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
     dependency.srcAccessMask = 0;
     dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
     dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    if(drawOver)
+    {
+        //whatever drew the image, a render pass or a blit, has to land first. the layout transitions
+        //those end with only chain into a dependency on every stage.
+        dependency.srcStageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+        dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+        dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    }
+
+    uint32_t dependencyCount = 1;
+    if(finalLayout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL)
+    {
+        //the implicit dependency out of the pass only waits at bottom of pipe, which nothing after it
+        //can chain a barrier onto, so the transfer that reads the image has to be ordered here
+        VkSubpassDependency& toTransfer = dependencies[dependencyCount++];
+        toTransfer.srcSubpass = 0;
+        toTransfer.dstSubpass = VK_SUBPASS_EXTERNAL;
+        toTransfer.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        toTransfer.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        toTransfer.dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        toTransfer.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    }
 
     VkRenderPassCreateInfo renderPassInfo{};
     renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
@@ -562,18 +682,18 @@ VkRenderPass createRenderPass(VkDevice const& logicalDevice, VkFormat const& for
     renderPassInfo.pAttachments = &colorAttachment;
     renderPassInfo.subpassCount = 1;
     renderPassInfo.pSubpasses = &subpass;
-    renderPassInfo.dependencyCount = 1;
-    renderPassInfo.pDependencies = &dependency;
+    renderPassInfo.dependencyCount = dependencyCount;
+    renderPassInfo.pDependencies = dependencies.data();
 
     VkRenderPass reply;
-    if(VK_FAILED(vkCreateRenderPass(logicalDevice, &renderPassInfo, nullptr, &reply)))
+    if(VK_FAILED(vkCreateRenderPass(logicalDevice, &renderPassInfo, hostAllocator.callbacks(VK_OBJECT_TYPE_RENDER_PASS), &reply)))
     {
         throw std::runtime_error("Failed to create the render pass.");
     }
     return reply;
 }
 
-vector<VkFramebuffer> createFreamebuffers(VkDevice const& logicalDevice, image_views const& imageViews, VkRenderPass const& renderPass, VkExtent2D const& extent)
+vector<VkFramebuffer> createFreamebuffers(VkDevice const& logicalDevice, image_views const& imageViews, VkRenderPass const& renderPass, VkExtent2D const& extent, host_allocator& hostAllocator)
 {
     vector<VkFramebuffer> reply;
     reply.resize(imageViews.size());
@@ -589,7 +709,7 @@ vector<VkFramebuffer> createFreamebuffers(VkDevice const& logicalDevice, image_v
         framebufferInfo.height = extent.height;
         framebufferInfo.layers = 1;
 
-        if(VK_FAILED(vkCreateFramebuffer(logicalDevice, &framebufferInfo, nullptr, &reply[&imageView - &imageViews[0]])))
+        if(VK_FAILED(vkCreateFramebuffer(logicalDevice, &framebufferInfo, hostAllocator.callbacks(VK_OBJECT_TYPE_FRAMEBUFFER), &reply[&imageView - &imageViews[0]])))
         {
             throw std::runtime_error("Failed to create framebuffer.");
         }
@@ -597,71 +717,189 @@ vector<VkFramebuffer> createFreamebuffers(VkDevice const& logicalDevice, image_v
     return reply;
 }
 
-VkCommandPool createCommandPool(VkDevice const& logicalDevice, queue_family_index_t const& graphicsFamily)
+uint32_t findMemoryType(VkPhysicalDevice const& physicalDevice, uint32_t const typeFilter, VkMemoryPropertyFlags const properties)
 {
-    VkCommandPoolCreateInfo poolInfo{};
-    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-    poolInfo.queueFamilyIndex = graphicsFamily;
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+    for(uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i)
+    {
+        if((typeFilter & (1 << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+        {
+            return i;
+        }
+    }
+    throw std::runtime_error("Failed to find a suitable memory type.");
+}
 
-    VkCommandPool reply;
-    if(VK_FAILED(vkCreateCommandPool(logicalDevice, &poolInfo, nullptr, &reply)))
+std::tuple<VkBuffer, VkDeviceMemory> createBuffer(VkPhysicalDevice const& physicalDevice,
+    VkDevice const& logicalDevice,
+    VkDeviceSize const size,
+    VkBufferUsageFlags const usage,
+    VkMemoryPropertyFlags const properties,
+    host_allocator& hostAllocator,
+    vector<queue_family_index_t> const& sharingFamilies)
+{
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = size;
+    bufferInfo.usage = usage;
+    //the families can coincide, e.g. when compute falls back to the graphics family, and concurrent
+    //sharing needs each one only once
+    std::set<queue_family_index_t> const uniqueFamilies(begin(sharingFamilies), end(sharingFamilies));
+    vector<queue_family_index_t> const families(begin(uniqueFamilies), end(uniqueFamilies));
+    if(families.size() > 1)
+    {
+        bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        bufferInfo.queueFamilyIndexCount = static_cast<uint32_t>(families.size());
+        bufferInfo.pQueueFamilyIndices = families.data();
+    }
+    else
     {
-        throw std::runtime_error("Failed to create command pool.");
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     }
-    return reply;
+
+    VkBuffer buffer;
+    if(VK_FAILED(vkCreateBuffer(logicalDevice, &bufferInfo, hostAllocator.callbacks(VK_OBJECT_TYPE_BUFFER), &buffer)))
+    {
+        throw std::runtime_error("Failed to create buffer.");
+    }
+
+    VkMemoryRequirements memoryRequirements;
+    vkGetBufferMemoryRequirements(logicalDevice, buffer, &memoryRequirements);
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = memoryRequirements.size;
+    allocInfo.memoryTypeIndex = findMemoryType(physicalDevice, memoryRequirements.memoryTypeBits, properties);
+
+    VkDeviceMemory memory;
+    if(VK_FAILED(vkAllocateMemory(logicalDevice, &allocInfo, hostAllocator.callbacks(VK_OBJECT_TYPE_DEVICE_MEMORY), &memory)))
+    {
+        throw std::runtime_error("Failed to allocate buffer memory.");
+    }
+    vkBindBufferMemory(logicalDevice, buffer, memory, 0);
+    return { buffer, memory };
 }
 
-vector<VkCommandBuffer> createCommandBuffers(VkDevice const& logicalDevice,
-    VkCommandPool const& commandPool,
-    uint32_t const& frameBufferCount,
-    VkRenderPass const& renderPass,
-    vector<VkFramebuffer> const& frameBuffers,
+std::tuple<VkImage, VkDeviceMemory> createImage(VkPhysicalDevice const& physicalDevice,
+    VkDevice const& logicalDevice,
     VkExtent2D const& extent,
-    VkPipeline const& graphicsPipeline)
+    uint32_t const mipLevels,
+    VkFormat const format,
+    VkImageUsageFlags const usage,
+    host_allocator& hostAllocator)
 {
-    vector<VkCommandBuffer> reply;
-    reply.resize(frameBufferCount);
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.extent = { extent.width, extent.height, 1 };
+    imageInfo.mipLevels = mipLevels;
+    imageInfo.arrayLayers = 1;
+    imageInfo.format = format;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageInfo.usage = usage;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-    VkCommandBufferAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.commandPool = commandPool;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandBufferCount = static_cast<uint32_t>(reply.size());
+    VkImage image;
+    if(VK_FAILED(vkCreateImage(logicalDevice, &imageInfo, hostAllocator.callbacks(VK_OBJECT_TYPE_IMAGE), &image)))
+    {
+        throw std::runtime_error("Failed to create image.");
+    }
+
+    VkMemoryRequirements memoryRequirements;
+    vkGetImageMemoryRequirements(logicalDevice, image, &memoryRequirements);
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = memoryRequirements.size;
+    allocInfo.memoryTypeIndex = findMemoryType(physicalDevice, memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    VkDeviceMemory memory;
+    if(VK_FAILED(vkAllocateMemory(logicalDevice, &allocInfo, hostAllocator.callbacks(VK_OBJECT_TYPE_DEVICE_MEMORY), &memory)))
+    {
+        throw std::runtime_error("Failed to allocate image memory.");
+    }
+    vkBindImageMemory(logicalDevice, image, memory, 0);
+    return { image, memory };
+}
 
-    if(VK_FAILED(vkAllocateCommandBuffers(logicalDevice, &allocInfo, reply.data())))
+VkPipelineCache createPipelineCache(VkDevice const& logicalDevice, std::string const& fileName, host_allocator& hostAllocator)
+{
+    vector<char> initialData;
+    if(std::ifstream(fileName, std::ios::binary).is_open())
     {
-        throw std::runtime_error("Failed to allocate command buffers.");
+        initialData = readFile(fileName);
     }
 
-    for(VkCommandBuffer const& commandBuffer : reply)
+    VkPipelineCacheCreateInfo cacheInfo{};
+    cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cacheInfo.initialDataSize = initialData.size();
+    cacheInfo.pInitialData = initialData.data();
+
+    VkPipelineCache reply;
+    if(VK_FAILED(vkCreatePipelineCache(logicalDevice, &cacheInfo, hostAllocator.callbacks(VK_OBJECT_TYPE_PIPELINE_CACHE), &reply)))
     {
-        VkCommandBufferBeginInfo beginInfo{};
-        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        throw std::runtime_error("Failed to create pipeline cache.");
+    }
+    return reply;
+}
 
-        if(VK_FAILED(vkBeginCommandBuffer(commandBuffer, &beginInfo)))
-        {
-            throw std::runtime_error("Failed to begin recording command buffer.");
-        }
+void savePipelineCache(VkDevice const& logicalDevice, VkPipelineCache const& pipelineCache, std::string const& fileName)
+{
+    size_t dataSize = 0;
+    vkGetPipelineCacheData(logicalDevice, pipelineCache, &dataSize, nullptr);
+    vector<char> data(dataSize);
+    vkGetPipelineCacheData(logicalDevice, pipelineCache, &dataSize, data.data());
 
-        VkRenderPassBeginInfo renderPassInfo{};
-        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-        renderPassInfo.renderPass = renderPass;
-        renderPassInfo.framebuffer = frameBuffers[&commandBuffer - &reply[0]];
-        renderPassInfo.renderArea.offset = { 0,0 };
-        renderPassInfo.renderArea.extent = extent;
-        VkClearValue clearColor = { 0.0f, 0.0f, 0.0f, 1.0f };
-        renderPassInfo.clearValueCount = 1;
-        renderPassInfo.pClearValues = &clearColor;
-
-        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
-        vkCmdDraw(commandBuffer, 3, 1, 0, 0);
-
-        vkCmdEndRenderPass(commandBuffer);
-        if(VK_FAILED(vkEndCommandBuffer(commandBuffer)))
-        {
-            throw std::runtime_error("Failed to record command buffer.");
-        }
+    std::ofstream file(fileName, std::ios::binary);
+    file.write(data.data(), dataSize);
+}
+
+VkCommandPool createCommandPool(VkDevice const& logicalDevice, queue_family_index_t const& graphicsFamily, host_allocator& hostAllocator, VkCommandPoolCreateFlags const flags)
+{
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = flags;
+    poolInfo.queueFamilyIndex = graphicsFamily;
+
+    VkCommandPool reply;
+    if(VK_FAILED(vkCreateCommandPool(logicalDevice, &poolInfo, hostAllocator.callbacks(VK_OBJECT_TYPE_COMMAND_POOL), &reply)))
+    {
+        throw std::runtime_error("Failed to create command pool.");
     }
     return reply;
+}
+
+void recordUpscaleBlit(VkCommandBuffer const& commandBuffer, upscale_blit const& upscale, uint32_t const index, VkExtent2D const& extent)
+{
+    //the render pass left the source in transfer layout and its outgoing dependency orders the blit
+    //after its writes. the destination's old contents are thrown away, it waited on acquire at colour
+    //attachment output.
+    VkImageMemoryBarrier toTransfer{};
+    toTransfer.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    toTransfer.srcAccessMask = 0;
+    toTransfer.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    toTransfer.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    toTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    toTransfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toTransfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toTransfer.image = upscale.destinationImages[index];
+    toTransfer.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &toTransfer);
+
+    VkImageBlit blit{};
+    blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    blit.srcOffsets[1] = { static_cast<int32_t>(upscale.renderExtent.width), static_cast<int32_t>(upscale.renderExtent.height), 1 };
+    blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    blit.dstOffsets[1] = { static_cast<int32_t>(extent.width), static_cast<int32_t>(extent.height), 1 };
+    vkCmdBlitImage(commandBuffer, upscale.sourceImages[index], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, upscale.destinationImages[index], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+
+    VkImageMemoryBarrier toPresent = toTransfer;
+    toPresent.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    toPresent.dstAccessMask = 0;
+    toPresent.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    toPresent.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &toPresent);
 }
\ No newline at end of file
@@ -8,9 +8,13 @@
 #include <iostream>
 #include <optional>
 #include <stdexcept>
+#include <string>
 #include <vector>
 #include <set>
 
+#include "gpu_stats.h"
+#include "host_allocator.h"
+
 #pragma warning(disable: 26812) //enum class warning
 #pragma warning(disable: 26495) //unitialized member warning
 
@@ -26,6 +30,7 @@ using queue_family_indices = struct queue_familyindex_struct
 {
     std::optional<queue_family_index_t> graphicsFamily;
     std::optional<queue_family_index_t> presentationFamily;
+    std::optional<queue_family_index_t> computeFamily;//a compute only family when there is one, so work on it overlaps rendering
 
     bool isComplete() { return graphicsFamily.has_value() && presentationFamily.has_value(); }
 };
@@ -39,8 +44,33 @@ struct swap_chain_support_details
     vector<VkPresentModeKHR> presentModes;
 };
 
+//what differs between the pipelines built by createGraphicsPipeline, the defaults are the hardcoded triangle
+struct graphics_pipeline_description
+{
+    std::string vertexShader = "shaders/vert.spv";
+    std::string fragmentShader = "shaders/frag.spv";
+    vector<VkVertexInputBindingDescription> vertexBindings;
+    vector<VkVertexInputAttributeDescription> vertexAttributes;
+    VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
+    bool dynamicViewport = false;//viewport and scissor set while recording instead of baked in
+    bool alphaBlend = false;//blended over what's already there by source alpha
+    vector<VkDescriptorSetLayout> setLayouts;
+};
+
+//draw into the top left renderExtent of the framebuffers, then blit that up to fill the matching
+//destination image. the framebuffers' images must end the render pass in transfer source layout
+//and the pipelines need a dynamic viewport.
+struct upscale_blit
+{
+    VkExtent2D renderExtent{};
+    vector<VkImage> sourceImages;
+    vector<VkImage> destinationImages;//left in present layout
+};
+
 constexpr uint32_t windowWidth = 800;
 constexpr uint32_t windowHeight = 600;
+constexpr uint32_t presentationTargetCount = 2;//windows, each with its own swapchain, fed from one device
 constexpr VkQueueFlagBits queueRequirements = VK_QUEUE_GRAPHICS_BIT;
 constexpr int maxFramesInFlight = 2;
 
@@ -61,16 +91,20 @@ constexpr bool enableValidationLayers = false;
 constexpr bool enableValidationLayers = true;
 #endif
 
-VkInstance createInstance();
+//windowless instances skip the extensions glfw asks for
+VkInstance createInstance(host_allocator& hostAllocator, bool const presentationSupport);
 
 void check_specified_validation_layers_supported();
 
+bool checkDeviceExtensionSupport(VkPhysicalDevice const& toCheck, vector<char const*> requiredExtensions);
+
 VkPhysicalDevice pickPhysicalDevice(VkInstance const& vulkanInstance, VkSurfaceKHR const& surface, VkQueueFlagBits const requirements, vector<char const*> const& requiredExtensions);
 
 //todo: split into three functions
-std::tuple<VkDevice, queue_family_index_t, queue_family_index_t> createLogicalDevice(VkPhysicalDevice const& physicalDevice, VkSurfaceKHR const& surface, VkQueueFlagBits const requirements, vector<const char*> const& deviceExtensions);
+//returns the device and its graphics, presentation and compute families, each with one queue
+std::tuple<VkDevice, queue_family_index_t, queue_family_index_t, queue_family_index_t> createLogicalDevice(VkPhysicalDevice const& physicalDevice, VkSurfaceKHR const& surface, VkQueueFlagBits const requirements, vector<const char*> const& deviceExtensions, VkPhysicalDeviceFeatures const& deviceFeatures, host_allocator& hostAllocator);
 
-VkSurfaceKHR createSurface(VkInstance const& instance, GLFWwindow* window);
+VkSurfaceKHR createSurface(VkInstance const& instance, GLFWwindow* window, host_allocator& hostAllocator);
 
 swap_chain_support_details querySwapChainSupport(VkPhysicalDevice const& device, VkSurfaceKHR const& surface);
 
@@ -80,27 +114,59 @@ VkPresentModeKHR chooseSwapPresentMode(vector<VkPresentModeKHR> const& available
 
 VkExtent2D chooseSwapExtent(VkSurfaceCapabilitiesKHR const& capabilities);
 
-VkSwapchainKHR createSwapChain(swap_chain_support_details const& swapChainSupport, VkSurfaceKHR const& surface, VkPhysicalDevice const& physicalDevice, VkDevice const& logicalDevice);
+VkSwapchainKHR createSwapChain(swap_chain_support_details const& swapChainSupport, VkSurfaceKHR const& surface, VkPhysicalDevice const& physicalDevice, VkDevice const& logicalDevice, host_allocator& hostAllocator);
+
+VkImageView createImageView(VkImage const& image, VkFormat const& format, uint32_t const levelCount, VkDevice const& logicalDevice, host_allocator& hostAllocator);
 
-image_views createImageViews(image_list const& images, VkFormat const& format, VkDevice const& logicalDevice);
+image_views createImageViews(image_list const& images, VkFormat const& format, VkDevice const& logicalDevice, host_allocator& hostAllocator);
 
 //todo: see if there is a better way to destory pipeline layout
-std::tuple<VkPipeline, VkPipelineLayout> createGraphicsPipeline(VkDevice const& logicalDevice, VkExtent2D const& swapchainExtent, VkRenderPass const& renderPass);
+std::tuple<VkPipeline, VkPipelineLayout> createGraphicsPipeline(VkDevice const& logicalDevice,
+    VkExtent2D const& swapchainExtent,
+    VkRenderPass const& renderPass,
+    VkPipelineCache const& pipelineCache,
+    graphics_pipeline_description const& description,
+    host_allocator& hostAllocator);
+
+std::tuple<VkPipeline, VkPipelineLayout> createComputePipeline(VkDevice const& logicalDevice,
+    std::string const& computeShader,
+    vector<VkDescriptorSetLayout> const& setLayouts,
+    VkPipelineCache const& pipelineCache,
+    host_allocator& hostAllocator);
 
 vector<char> readFile(std::string const& fileName);
 
-VkShaderModule createShaderModule(vector<char> const& code, VkDevice const& logicalDevice);
+VkShaderModule createShaderModule(vector<char> const& code, VkDevice const& logicalDevice, host_allocator& hostAllocator);
 
-VkRenderPass createRenderPass(VkDevice const& logicalDevice, VkFormat const& format);
+//with a load op of LOAD the pass draws over an image that is already in finalLayout
+VkRenderPass createRenderPass(VkDevice const& logicalDevice, VkFormat const& format, VkImageLayout const finalLayout, host_allocator& hostAllocator, VkAttachmentLoadOp const loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR);
 
-vector<VkFramebuffer> createFreamebuffers(VkDevice const& logicalDevice, image_views const& imageViews, VkRenderPass const& renderPass, VkExtent2D const& extent);
+vector<VkFramebuffer> createFreamebuffers(VkDevice const& logicalDevice, image_views const& imageViews, VkRenderPass const& renderPass, VkExtent2D const& extent, host_allocator& hostAllocator);
 
-VkCommandPool createCommandPool(VkDevice const& logicalDevice, queue_family_index_t const& graphicsFamily);
+uint32_t findMemoryType(VkPhysicalDevice const& physicalDevice, uint32_t const typeFilter, VkMemoryPropertyFlags const properties);
 
-vector<VkCommandBuffer> createCommandBuffers(VkDevice const& logicalDevice,
-    VkCommandPool const& commandPool,
-    uint32_t const& frameBufferCount,
-    VkRenderPass const& renderPass,
-    vector<VkFramebuffer> const& frameBuffers,
+std::tuple<VkBuffer, VkDeviceMemory> createBuffer(VkPhysicalDevice const& physicalDevice,
+    VkDevice const& logicalDevice,
+    VkDeviceSize const size,
+    VkBufferUsageFlags const usage,
+    VkMemoryPropertyFlags const properties,
+    host_allocator& hostAllocator,
+    vector<queue_family_index_t> const& sharingFamilies = {});//concurrent between these when there is more than one
+
+std::tuple<VkImage, VkDeviceMemory> createImage(VkPhysicalDevice const& physicalDevice,
+    VkDevice const& logicalDevice,
     VkExtent2D const& extent,
-    VkPipeline const& graphicsPipeline);
\ No newline at end of file
+    uint32_t const mipLevels,
+    VkFormat const format,
+    VkImageUsageFlags const usage,
+    host_allocator& hostAllocator);
+
+//seeded from fileName when it exists, drivers ignore data from a different device or version
+VkPipelineCache createPipelineCache(VkDevice const& logicalDevice, std::string const& fileName, host_allocator& hostAllocator);
+
+void savePipelineCache(VkDevice const& logicalDevice, VkPipelineCache const& pipelineCache, std::string const& fileName);
+
+VkCommandPool createCommandPool(VkDevice const& logicalDevice, queue_family_index_t const& graphicsFamily, host_allocator& hostAllocator, VkCommandPoolCreateFlags const flags = 0);
+
+//upscale's source for index into its destination, extent being the destination's
+void recordUpscaleBlit(VkCommandBuffer const& commandBuffer, upscale_blit const& upscale, uint32_t const index, VkExtent2D const& extent);
\ No newline at end of file